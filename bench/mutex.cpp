@@ -0,0 +1,78 @@
+/*
+ *  Compares the mutex types usable with synchronized under
+ *  varying contention (number of threads) and hold times.
+ *
+ *  usage: mutex_bench [operations per thread]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fn/futex_mutex.hpp>
+#include <fn/synchronized.hpp>
+using namespace fn;
+
+static void work(unsigned const n)
+{
+    for(unsigned i = 0; i < n; ++i){
+        asm volatile("" ::: "memory");
+    }
+}
+
+template<typename Mutex>
+static double run(unsigned const threads, unsigned const hold, unsigned const ops)
+{
+    synchronized<uint64_t,Mutex> counter(0);
+    std::vector<std::thread> workers;
+
+    auto const start = std::chrono::steady_clock::now();
+    for(unsigned t = 0; t < threads; ++t){
+        workers.emplace_back([&]{
+            for(unsigned i = 0; i < ops; ++i){
+                counter >>[&](uint64_t& c){
+                    ++c;
+                    work(hold);
+                };
+                work(hold);
+            }
+        });
+    }
+    for(auto& w: workers){ w.join(); }
+    auto const end = std::chrono::steady_clock::now();
+
+    if(*counter.guard() != uint64_t(threads) * ops){
+        std::fprintf(stderr, "lost updates\n");
+        std::exit(1);
+    }
+
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return double(ns) / (double(threads) * ops);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned const ops = argc > 1 ? std::atoi(argv[1]) : 200000;
+    unsigned const holds[] = {0, 50, 500};
+    unsigned const max_threads = std::max(2U, 2*std::thread::hardware_concurrency());
+
+    std::printf("%8s %6s %12s %16s %16s %12s   (ns/op)\n",
+        "threads", "hold", "std::mutex", "ticket_spinlock", "adaptive_mutex", "mcs_lock");
+
+    for(unsigned threads = 1; threads <= max_threads; threads *= 2){
+        for(auto hold: holds){
+            std::printf("%8u %6u %12.1f %16.1f %16.1f %12.1f\n",
+                threads, hold,
+                run<std::mutex>(threads, hold, ops),
+                run<ticket_spinlock>(threads, hold, ops),
+                run<adaptive_mutex>(threads, hold, ops),
+                run<mcs_lock>(threads, hold, ops)
+            );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Throughput of fill, copy and compare of slices, and of
+ *  scanning bytes for a delimiter with find and count,
+ *  for buffer sizes from 1 to 64 MB.
+ *
+ *  usage: slice_bench [repetitions]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <fn/slice.hpp>
+using namespace fn;
+
+template<typename F>
+static double gbps(size_t const bytes, unsigned const reps, F const& f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < reps; ++i){
+        f();
+        asm volatile("" ::: "memory");
+    }
+    auto const end = std::chrono::steady_clock::now();
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return double(bytes) * reps / double(ns);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned const reps = argc > 1 ? std::atoi(argv[1]) : 20;
+
+    std::printf("%8s %10s %10s %10s %10s %10s   (GB/s)\n", "MB", "fill", "copy", "compare", "find", "count");
+
+    for(size_t mb = 1; mb <= 64; mb *= 2){
+        auto const n = mb * 1024 * 1024 / sizeof(uint64_t);
+        std::vector<uint64_t> a(n, 1);
+        std::vector<uint64_t> b(n, 2);
+        auto const sa = make_slice(a);
+        auto const sb = make_slice(b);
+        auto const bytes = slice<uint8_t>(reinterpret_cast<uint8_t*>(a.data()), n*sizeof(uint64_t));
+        bool equal = true;
+        size_t found = 0;
+
+        auto const fill = gbps(n*sizeof(uint64_t), reps, [&]{ sa.fill(3); });
+        auto const copy = gbps(n*sizeof(uint64_t), reps, [&]{ sb.copy(sa); });
+        auto const compare = gbps(n*sizeof(uint64_t), reps, [&]{ equal &= sa.compare(sb); });
+        // no match, so both scan the whole buffer
+        auto const find = gbps(bytes.size(), reps, [&]{ found += bytes.find('\n').valid(); });
+        auto const count = gbps(bytes.size(), reps, [&]{ found += bytes.count('\n'); });
+
+        if(!equal || found){
+            std::fprintf(stderr, "wrong result\n");
+            return 1;
+        }
+        std::printf("%8zu %10.2f %10.2f %10.2f %10.2f %10.2f\n", mb, fill, copy, compare, find, count);
+    }
+    return 0;
+}
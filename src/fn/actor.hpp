@@ -0,0 +1,134 @@
+#ifndef _371ffb12_5e6d_4d5c_af22_081ceea376bb
+#define _371ffb12_5e6d_4d5c_af22_081ceea376bb
+
+#include <exception>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "channel.hpp"
+
+namespace fn {
+
+namespace fn_ {
+
+template<typename R>
+struct Fulfil
+{
+    template<typename F, typename V>
+    static void run(std::promise<R>& p, F& f, V& v) { p.set_value(f(v)); }
+};
+
+template<>
+struct Fulfil<void>
+{
+    template<typename F, typename V>
+    static void run(std::promise<void>& p, F& f, V& v) { f(v); p.set_value(); }
+};
+
+}
+
+/*
+ * Owns a value of type T and a thread that is the only one to ever
+ * touch it. Instead of locking the value, other threads post functors
+ * that are executed on the owner thread, in batches, so the value stays
+ * in the cache of one core:
+ *
+ *  actor<Stats> stats;
+ *  auto total = stats.post([](Stats& s){ s.add(x); return s.total; });
+ *  total.get();
+ *
+ * post returns a std::future for the result of the functor (references
+ * are returned by value). If the queue is full, the job is not accepted
+ * and the returned future is not valid().
+ */
+template<typename T, size_t QueueSize=1024, size_t BatchSize=64>
+class actor
+{
+    struct Job
+    {
+        virtual ~Job() {}
+        virtual void run(T&) = 0;
+    };
+
+    template<typename F, typename R>
+    struct Task : Job
+    {
+        F f;
+        std::promise<R> promise;
+
+        Task(F const& f): f(f) {}
+
+        void run(T& value)
+        {
+            try{
+                fn_::Fulfil<R>::run(promise,f,value);
+            }
+            catch(...){
+                promise.set_exception(std::current_exception());
+            }
+        }
+    };
+
+    typedef std::unique_ptr<Job> JobPtr;
+
+    Channel<JobPtr> channel;
+    T value;
+    std::thread owner;
+
+    void run()
+    {
+        std::vector<JobPtr> jobs;
+        jobs.reserve(BatchSize);
+        for(;;){
+            channel.receive.batch(100,jobs,BatchSize);
+            for(auto& job: jobs){
+                // an empty job is the request to stop
+                if(!job){ return; }
+                job->run(value);
+            }
+            jobs.clear();
+        }
+    }
+
+public:
+    template<typename ...Args>
+    actor(Args... args):
+        channel(QueueSize),
+        value(args...),
+        owner([this]{ run(); })
+    {}
+
+    actor(actor const&) = delete;
+
+    /*
+     * Runs all jobs posted so far, then stops the owner thread.
+     */
+    ~actor()
+    {
+        while(!channel.send(JobPtr())){
+            std::this_thread::yield();
+        }
+        owner.join();
+    }
+
+    template<typename F>
+    auto post(F const& f)
+        -> std::future<typename std::decay<decltype(f(std::declval<T&>()))>::type>
+    {
+        typedef typename std::decay<decltype(f(std::declval<T&>()))>::type R;
+
+        auto task = new Task<F,R>(f);
+        auto result = task->promise.get_future();
+        if(!channel.send(JobPtr(task))){
+            return std::future<R>();
+        }
+        return result;
+    }
+};
+
+}
+
+#endif
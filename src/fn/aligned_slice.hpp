@@ -0,0 +1,183 @@
+#ifndef _c7e25a90_84fd_4b1e_a6d3_190f5b2e8c4a
+#define _c7e25a90_84fd_4b1e_a6d3_190f5b2e8c4a
+
+/*
+ * Slices with an alignment known at compile time, and buffers
+ * that provide them. POSIX only.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include "slice.hpp"
+
+namespace fn {
+
+/*
+ * A slice whose first element is aligned to Align bytes. The alignment
+ * is checked once, when the slice is made, so kernels can rely on it
+ * without checks or peeling:
+ *
+ *  aligned_slice<float,32>::from(s) >>[](aligned_slice<float,32> a){
+ *      auto p = a.data();   // known to be 32 byte aligned
+ *  };
+ *
+ * Sub-slices stay aligned if their offset is a multiple of Align bytes.
+ */
+template<typename T, size_t Align>
+class aligned_slice
+{
+    static_assert(Align && !(Align & (Align-1)), "fn::aligned_slice: alignment must be a power of two");
+    static_assert(Align >= alignof(T), "fn::aligned_slice: alignment below the alignment of T");
+
+    slice<T> s;
+
+    explicit aligned_slice(slice<T> const s): s(s) {}
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = T*;
+
+    static size_t const alignment = Align;
+
+    aligned_slice() {}
+
+    static bool is_aligned(T const* const p)
+    {
+        return !(reinterpret_cast<uintptr_t>(p) & (Align-1));
+    }
+
+    /*
+     * Empty if the data of s is not aligned.
+     */
+    static optional<aligned_slice> from(slice<T> const s)
+    {
+        if(!is_aligned(s.data())){ return {}; }
+        return aligned_slice(s);
+    }
+
+    T* data() const
+    {
+        return static_cast<T*>(__builtin_assume_aligned(s.data(), Align));
+    }
+
+    size_t size() const { return s.size(); }
+    T* begin() const { return data(); }
+    T* end() const { return data() + size(); }
+
+    optional<T&> operator[](size_t const i) const { return s[i]; }
+
+    operator slice<T>() const { return s; }
+    slice<T> get() const { return s; }
+
+    aligned_slice first(size_t const n) const { return aligned_slice(s.first(n)); }
+
+    template<size_t O>
+    aligned_slice subslice() const
+    {
+        static_assert((O*sizeof(T)) % Align == 0, "fn::aligned_slice: offset breaks alignment");
+        return aligned_slice(s.subslice(O));
+    }
+
+    /*
+     * Empty if the offset breaks the alignment.
+     */
+    optional<aligned_slice> subslice(size_t const o) const
+    {
+        if((o*sizeof(T)) % Align){ return {}; }
+        return aligned_slice(s.subslice(o));
+    }
+};
+
+/*
+ * Owning array of n value initialized elements, aligned to Align bytes.
+ * With hugepage set, the memory is aligned to 2MB and the kernel is
+ * asked to back it with huge pages, which cuts TLB misses on large
+ * buffers. Throws std::bad_alloc if the memory can not be allocated.
+ */
+template<typename T, size_t Align=64>
+class aligned_buffer
+{
+    static size_t const huge_page = 2*1024*1024;
+
+    T* _data = nullptr;
+    size_t _size = 0;
+
+    void release()
+    {
+        while(_size){
+            _data[--_size].~T();
+        }
+        free(_data);
+        _data = nullptr;
+    }
+
+public:
+    explicit aligned_buffer(size_t const n, bool const hugepage=false)
+    {
+        if(!n){ return; }
+
+        auto const alignment = hugepage && Align < huge_page ? huge_page : Align;
+        auto bytes = n*sizeof(T);
+        if(hugepage){ bytes = (bytes + huge_page - 1) / huge_page * huge_page; }
+
+        void* p = nullptr;
+        if(posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, bytes)){
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if(hugepage){ madvise(p, bytes, MADV_HUGEPAGE); }
+#endif
+
+        _data = static_cast<T*>(p);
+        try{
+            for(; _size < n; ++_size){
+                new (_data + _size) T();
+            }
+        }
+        catch(...){
+            release();
+            throw;
+        }
+    }
+
+    aligned_buffer(aligned_buffer&& o): _data(o._data), _size(o._size)
+    {
+        o._data = nullptr;
+        o._size = 0;
+    }
+
+    aligned_buffer(aligned_buffer const&) = delete;
+    aligned_buffer& operator=(aligned_buffer const&) = delete;
+
+    ~aligned_buffer() { release(); }
+
+    size_t size() const { return _size; }
+    T* data() const { return _data; }
+    T* begin() const { return _data; }
+    T* end() const { return _data + _size; }
+
+    optional<T&> operator[](size_t const i) const
+    {
+        if(i<_size){
+            return _data[i];
+        }
+        else{
+            return {};
+        }
+    }
+
+    aligned_slice<T,Align> get() const
+    {
+        return ~aligned_slice<T,Align>::from(slice<T>(_data,_size));
+    }
+
+    operator aligned_slice<T,Align>() const { return get(); }
+    operator slice<T>() const { return slice<T>(_data,_size); }
+};
+
+}
+
+#endif
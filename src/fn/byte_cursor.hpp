@@ -0,0 +1,317 @@
+#ifndef _3e9d7b51_c046_4a8f_92e1_f5a8b06d3c27
+#define _3e9d7b51_c046_4a8f_92e1_f5a8b06d3c27
+
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include "slice.hpp"
+
+namespace fn {
+
+enum class byte_order { little, big };
+
+namespace fn_ {
+
+inline uint8_t byte_swap(uint8_t const v) { return v; }
+inline uint16_t byte_swap(uint16_t const v) { return __builtin_bswap16(v); }
+inline uint32_t byte_swap(uint32_t const v) { return __builtin_bswap32(v); }
+inline uint64_t byte_swap(uint64_t const v) { return __builtin_bswap64(v); }
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static byte_order const native_order = byte_order::big;
+#else
+static byte_order const native_order = byte_order::little;
+#endif
+
+template<typename T>
+using bits_of = typename std::make_unsigned<T>::type;
+
+template<typename T, byte_order E>
+T load(uint8_t const* const p)
+{
+    static_assert(std::is_integral<T>::value, "fn::byte_reader: integral types only");
+    bits_of<T> v;
+    std::memcpy(&v, p, sizeof(v));
+    if(E != native_order){ v = byte_swap(v); }
+    return T(v);
+}
+
+template<typename T, byte_order E>
+void store(uint8_t* const p, T const value)
+{
+    static_assert(std::is_integral<T>::value, "fn::byte_writer: integral types only");
+    auto v = bits_of<T>(value);
+    if(E != native_order){ v = byte_swap(v); }
+    std::memcpy(p, &v, sizeof(v));
+}
+
+// loads a T at p and moves p past it
+template<typename T, byte_order E>
+T load_next(uint8_t const*& p)
+{
+    auto const v = load<T,E>(p);
+    p += sizeof(T);
+    return v;
+}
+
+template<typename ...T> struct size_sum;
+template<> struct size_sum<> { static size_t const value = 0; };
+template<typename T, typename ...R>
+struct size_sum<T,R...> { static size_t const value = sizeof(T) + size_sum<R...>::value; };
+
+}
+
+/*
+ * Cursor that decodes a byte slice front to back without copying it:
+ *
+ *  byte_reader r(packet);
+ *  auto type = r.read<uint8_t>();
+ *  auto length = r.varint();
+ *  auto payload = r.prefixed<uint16_t,byte_order::big>();
+ *
+ * Every read checks for underrun and returns an empty optional instead
+ * of reading past the end; the cursor only advances on success.
+ */
+class byte_reader
+{
+    slice<uint8_t const> s;
+    size_t pos = 0;
+
+    uint8_t const* at() const { return s.data() + pos; }
+
+public:
+    byte_reader() {}
+    byte_reader(slice<uint8_t const> const s): s(s) {}
+
+    size_t position() const { return pos; }
+    size_t remaining() const { return s.size() - pos; }
+    bool empty() const { return !remaining(); }
+
+    /*
+     * The bytes not read yet.
+     */
+    slice<uint8_t const> rest() const { return s.subslice(pos); }
+
+    template<typename T, byte_order E=byte_order::little>
+    optional<T> read()
+    {
+        if(remaining() < sizeof(T)){ return {}; }
+        auto const v = fn_::load<T,E>(at());
+        pos += sizeof(T);
+        return v;
+    }
+
+    /*
+     * Reads several fields with a single bounds check.
+     */
+    template<byte_order E, typename ...T>
+    optional<std::tuple<T...>> fields()
+    {
+        auto const n = fn_::size_sum<T...>::value;
+        if(remaining() < n){ return {}; }
+        auto p = at();
+        // braced initializers are evaluated left to right
+        std::tuple<T...> v{fn_::load_next<T,E>(p)...};
+        pos += n;
+        return v;
+    }
+
+    /*
+     * Unsigned LEB128.
+     */
+    optional<uint64_t> varint()
+    {
+        uint64_t v = 0;
+        for(size_t i = 0, shift = 0; pos + i < s.size() && shift < 64; ++i, shift += 7){
+            auto const b = at()[i];
+            v |= uint64_t(b & 0x7f) << shift;
+            if(!(b & 0x80)){
+                pos += i + 1;
+                return v;
+            }
+        }
+        return {};
+    }
+
+    /*
+     * Signed LEB128.
+     */
+    optional<int64_t> svarint()
+    {
+        uint64_t v = 0;
+        for(size_t i = 0, shift = 0; pos + i < s.size() && shift < 64; ++i){
+            auto const b = at()[i];
+            v |= uint64_t(b & 0x7f) << shift;
+            shift += 7;
+            if(!(b & 0x80)){
+                if(shift < 64 && (b & 0x40)){ v |= ~uint64_t(0) << shift; }
+                pos += i + 1;
+                return int64_t(v);
+            }
+        }
+        return {};
+    }
+
+    /*
+     * The next n bytes, without copying them.
+     */
+    optional<slice<uint8_t const>> bytes(size_t const n)
+    {
+        if(remaining() < n){ return {}; }
+        auto const b = rest().first(n);
+        pos += n;
+        return b;
+    }
+
+    /*
+     * Bytes preceded by their length, stored as an L.
+     */
+    template<typename L, byte_order E=byte_order::little>
+    optional<slice<uint8_t const>> prefixed()
+    {
+        static_assert(std::is_unsigned<L>::value, "fn::byte_reader: length must be unsigned");
+        auto const start = pos;
+        auto const n = read<L,E>();
+        if(n.valid() && remaining() >= uint64_t(~n)){ return bytes(size_t(~n)); }
+        pos = start;
+        return {};
+    }
+
+    /*
+     * Bytes preceded by their length as a varint.
+     */
+    optional<slice<uint8_t const>> prefixed_varint()
+    {
+        auto const start = pos;
+        auto const n = varint();
+        if(n.valid() && remaining() >= ~n){ return bytes(size_t(~n)); }
+        pos = start;
+        return {};
+    }
+
+    bool skip(size_t const n)
+    {
+        if(remaining() < n){ return false; }
+        pos += n;
+        return true;
+    }
+};
+
+/*
+ * Cursor that encodes into a byte slice front to back.
+ * Writes that do not fit return false and write nothing.
+ */
+class byte_writer
+{
+    slice<uint8_t> s;
+    size_t pos = 0;
+
+    uint8_t* at() const { return s.data() + pos; }
+
+    template<byte_order E>
+    void put(uint8_t*) {}
+
+    template<byte_order E, typename T, typename ...R>
+    void put(uint8_t* const p, T const v, R const... rest)
+    {
+        fn_::store<T,E>(p, v);
+        put<E>(p + sizeof(T), rest...);
+    }
+
+public:
+    byte_writer() {}
+    byte_writer(slice<uint8_t> const s): s(s) {}
+
+    size_t position() const { return pos; }
+    size_t remaining() const { return s.size() - pos; }
+
+    /*
+     * The bytes written so far.
+     */
+    slice<uint8_t const> written() const { return slice<uint8_t const>(s.data(), pos); }
+
+    template<byte_order E=byte_order::little, typename T>
+    bool write(T const v)
+    {
+        if(remaining() < sizeof(T)){ return false; }
+        fn_::store<T,E>(at(), v);
+        pos += sizeof(T);
+        return true;
+    }
+
+    /*
+     * Writes several fields with a single bounds check.
+     */
+    template<byte_order E, typename ...T>
+    bool fields(T const... v)
+    {
+        auto const n = fn_::size_sum<T...>::value;
+        if(remaining() < n){ return false; }
+        put<E>(at(), v...);
+        pos += n;
+        return true;
+    }
+
+    bool varint(uint64_t v)
+    {
+        uint8_t b[10];
+        size_t n = 0;
+        do{
+            b[n] = uint8_t(v & 0x7f);
+            v >>= 7;
+            if(v){ b[n] |= 0x80; }
+            ++n;
+        }while(v);
+        return bytes(slice<uint8_t const>(b, n));
+    }
+
+    bool svarint(int64_t const value)
+    {
+        uint8_t b[10];
+        size_t n = 0;
+        auto v = value;
+        for(;;){
+            auto const low = uint8_t(v & 0x7f);
+            // arithmetic shift keeps the sign
+            v >>= 7;
+            if((v == 0 && !(low & 0x40)) || (v == -1 && (low & 0x40))){
+                b[n++] = low;
+                break;
+            }
+            b[n++] = low | 0x80;
+        }
+        return bytes(slice<uint8_t const>(b, n));
+    }
+
+    bool bytes(slice<uint8_t const> const b)
+    {
+        if(remaining() < b.size()){ return false; }
+        slice<uint8_t>(at(), b.size()).copy(b);
+        pos += b.size();
+        return true;
+    }
+
+    template<typename L, byte_order E=byte_order::little>
+    bool prefixed(slice<uint8_t const> const b)
+    {
+        static_assert(std::is_unsigned<L>::value, "fn::byte_writer: length must be unsigned");
+        if(remaining() < sizeof(L) + b.size() || uint64_t(b.size()) > uint64_t(L(~L(0)))){
+            return false;
+        }
+        write<E>(L(b.size()));
+        return bytes(b);
+    }
+
+    bool prefixed_varint(slice<uint8_t const> const b)
+    {
+        auto const start = pos;
+        if(varint(b.size()) && bytes(b)){ return true; }
+        pos = start;
+        return false;
+    }
+};
+
+}
+
+#endif
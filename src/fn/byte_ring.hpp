@@ -0,0 +1,173 @@
+#ifndef _8f2c4e17_b5d9_4a63_a0e8_6c93d1f7b254
+#define _8f2c4e17_b5d9_4a63_a0e8_6c93d1f7b254
+
+/*
+ * Byte ring buffer for stream I/O. POSIX only.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "slice.hpp"
+
+namespace fn {
+
+/*
+ * A region of a byte_ring: it wraps around the end of the
+ * storage at most once, so it is made of up to two slices.
+ */
+struct ring_parts
+{
+    slice<uint8_t> first;
+    slice<uint8_t> second;
+
+    size_t size() const { return first.size() + second.size(); }
+
+    /*
+     * Fills out with the non-empty parts, returns how many there are.
+     */
+    int iovecs(iovec (&out)[2]) const
+    {
+        int n = 0;
+        for(auto const& s: {first, second}){
+            if(s.size()){
+                out[n].iov_base = s.data();
+                out[n].iov_len = s.size();
+                ++n;
+            }
+        }
+        return n;
+    }
+};
+
+/*
+ * Fixed capacity FIFO of bytes that never moves its contents.
+ * Data is written into writable() and made visible with commit(),
+ * it is read from readable() and dropped with consume():
+ *
+ *  byte_ring in(64*1024);
+ *  in.read_from(socket);              // one readv
+ *  auto r = in.readable();            // up to two slices
+ *  in.consume(parse(r.first));
+ *
+ * The capacity is rounded up to a power of two. Regions are only valid
+ * until the next commit or consume.
+ */
+class byte_ring
+{
+    size_t const mask;
+    std::unique_ptr<uint8_t[]> data;
+    // positions grow without bound and are wrapped with mask on access
+    size_t read_pos = 0;
+    size_t write_pos = 0;
+
+    static size_t round_up(size_t const n)
+    {
+        size_t c = 1;
+        while(c < n){ c <<= 1; }
+        return c;
+    }
+
+    ring_parts region(size_t const from, size_t const length) const
+    {
+        auto const start = from & mask;
+        auto const head = std::min(length, capacity() - start);
+        return ring_parts{
+            slice<uint8_t>(data.get() + start, head),
+            slice<uint8_t>(data.get(), length - head),
+        };
+    }
+
+public:
+    explicit byte_ring(size_t const capacity):
+        mask(round_up(capacity) - 1),
+        data(new uint8_t[mask + 1])
+    {}
+
+    byte_ring(byte_ring const&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+    size_t size() const { return write_pos - read_pos; }
+    size_t space() const { return capacity() - size(); }
+    bool empty() const { return !size(); }
+
+    ring_parts readable() const { return region(read_pos, size()); }
+    ring_parts writable() const { return region(write_pos, space()); }
+
+    /*
+     * Makes n bytes written to writable() readable.
+     */
+    void commit(size_t const n) { write_pos += std::min(n, space()); }
+
+    /*
+     * Drops n bytes from the front of readable().
+     */
+    void consume(size_t const n)
+    {
+        read_pos += std::min(n, size());
+        // start over at the beginning, so that the next regions are in one piece
+        if(read_pos == write_pos){
+            read_pos = 0;
+            write_pos = 0;
+        }
+    }
+
+    /*
+     * Copies as much of source as fits, returns the number of bytes copied.
+     */
+    size_t write(slice<uint8_t const> const source)
+    {
+        auto const w = writable();
+        auto const rest = w.second.copy(w.first.copy(source));
+        auto const n = source.size() - rest.size();
+        commit(n);
+        return n;
+    }
+
+    /*
+     * Moves up to target.size() bytes out of the ring, returns their number.
+     */
+    size_t read(slice<uint8_t> const target)
+    {
+        auto const r = readable();
+        auto const n = std::min(target.size(), r.size());
+        auto const head = std::min(n, r.first.size());
+        target.copy(r.first.first(head));
+        target.subslice(head).copy(r.second.first(n - head));
+        consume(n);
+        return n;
+    }
+
+    /*
+     * Fills the free space with a single readv, returns its result.
+     */
+    ssize_t read_from(int const fd)
+    {
+        iovec v[2];
+        auto const n = writable().iovecs(v);
+        if(!n){ return 0; }
+        auto const r = ::readv(fd, v, n);
+        if(r > 0){ commit(size_t(r)); }
+        return r;
+    }
+
+    /*
+     * Sends the contents with a single writev, returns its result.
+     */
+    ssize_t write_to(int const fd)
+    {
+        iovec v[2];
+        auto const n = readable().iovecs(v);
+        if(!n){ return 0; }
+        auto const r = ::writev(fd, v, n);
+        if(r > 0){ consume(size_t(r)); }
+        return r;
+    }
+};
+
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <memory>
+#include <vector>
 #include "optional.hpp"
 
 namespace fn{
@@ -139,6 +140,30 @@ public:
             return {};
         }
 
+        /*
+         * Waits up to timeout_ms for a message, then moves up to max
+         * messages to the end of out, taking the lock only once.
+         * Returns the number of messages received.
+         */
+        size_t batch(uint64_t const timeout_ms, std::vector<T>& out, size_t const max)
+        {
+            if(!queue){ return 0; }
+            std::unique_lock<std::mutex> lock(queue->mutex);
+
+            if(queue->empty()){
+                queue->cv.wait_for(lock,std::chrono::milliseconds(timeout_ms));
+            }
+
+            size_t n = 0;
+            for(; n < max; ++n){
+                auto const p = queue->pop();
+                if(!p){ break; }
+                out.push_back(fn_::move(*p));
+                p->~T();
+            }
+            return n;
+        }
+
         template<typename F>
         void remove_if(F f)
         {
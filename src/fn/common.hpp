@@ -1,9 +1,17 @@
 #ifndef _33744f5c_1401_479e_857c_a098aa160a2e
 #define _33744f5c_1401_479e_857c_a098aa160a2e
 
+#include <cstddef>
+
 namespace fn{
 namespace fn_{
 
+/*
+ *  Assumed size of a cache line, used to keep data that is
+ *  accessed by different threads apart.
+ */
+static size_t const cache_line_size = 64;
+
 /*
  *  remove reference from a type, similar to std::remove_reference
  */
@@ -0,0 +1,259 @@
+#ifndef _a58f4662_4e67_4602_bd43_e3acce794aa2
+#define _a58f4662_4e67_4602_bd43_e3acce794aa2
+
+/*
+ * Mutexes tuned for short critical sections, usable as the Mutex
+ * parameter of synchronized and guard. Linux only.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace fn {
+
+namespace fn_ {
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/*
+ * Busy waiting step: spin for a while, then start giving
+ * the cpu to other threads, so that a descheduled lock holder
+ * can make progress.
+ */
+inline void spin_wait(unsigned& spins)
+{
+    if(spins < 128){
+        ++spins;
+        cpu_relax();
+    }
+    else{
+        sched_yield();
+    }
+}
+
+inline void futex_wait(std::atomic<int>& word, int const expected)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word),
+        FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<int>& word, int const count)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(&word),
+        FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+}
+
+/*
+ * Fair spinlock: threads acquire the lock in the order
+ * in which they started waiting.
+ */
+class ticket_spinlock
+{
+    std::atomic<uint32_t> next{0};
+    std::atomic<uint32_t> serving{0};
+
+public:
+    ticket_spinlock() {}
+    ticket_spinlock(ticket_spinlock const&) = delete;
+
+    void lock()
+    {
+        auto const ticket = next.fetch_add(1, std::memory_order_relaxed);
+        unsigned spins = 0;
+        while(serving.load(std::memory_order_acquire) != ticket){
+            fn_::spin_wait(spins);
+        }
+    }
+
+    bool try_lock()
+    {
+        auto current = serving.load(std::memory_order_acquire);
+        return next.compare_exchange_strong(
+            current, current + 1,
+            std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
+
+    void unlock()
+    {
+        serving.store(
+            serving.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release
+        );
+    }
+};
+
+/*
+ * Spins for a short time in the hope that the lock is released soon,
+ * then goes to sleep on a futex.
+ * The state is 0 when unlocked, 1 when locked and 2 when locked
+ * and there may be sleeping waiters.
+ */
+class adaptive_mutex
+{
+    std::atomic<int> state{0};
+
+public:
+    static unsigned const spin_limit = 100;
+
+    adaptive_mutex() {}
+    adaptive_mutex(adaptive_mutex const&) = delete;
+
+    bool try_lock()
+    {
+        int expected = 0;
+        return state.compare_exchange_strong(
+            expected, 1,
+            std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
+
+    void lock()
+    {
+        for(unsigned i = 0; i < spin_limit; ++i){
+            if(state.load(std::memory_order_relaxed) == 0 && try_lock()){
+                return;
+            }
+            fn_::cpu_relax();
+        }
+
+        while(state.exchange(2, std::memory_order_acquire) != 0){
+            fn_::futex_wait(state, 2);
+        }
+    }
+
+    void unlock()
+    {
+        if(state.exchange(0, std::memory_order_release) == 2){
+            fn_::futex_wake(state, 1);
+        }
+    }
+};
+
+/*
+ * MCS queue lock: every waiter spins on a flag of its own, so releasing
+ * the lock only touches the cache line of the next waiter.
+ * Queue nodes are taken from a per thread free list.
+ */
+class mcs_lock
+{
+    struct Node
+    {
+        std::atomic<Node*> next;
+        std::atomic<bool> locked;
+        Node* free;
+    };
+
+    struct NodePool
+    {
+        Node* free = nullptr;
+
+        Node* get()
+        {
+            auto n = free;
+            if(n){ free = n->free; }
+            else{ n = new Node; }
+            n->next.store(nullptr, std::memory_order_relaxed);
+            n->locked.store(true, std::memory_order_relaxed);
+            return n;
+        }
+
+        void put(Node* const n)
+        {
+            n->free = free;
+            free = n;
+        }
+
+        ~NodePool()
+        {
+            while(free){
+                auto n = free;
+                free = n->free;
+                delete n;
+            }
+        }
+    };
+
+    static NodePool& pool()
+    {
+        static thread_local NodePool p;
+        return p;
+    }
+
+    std::atomic<Node*> tail{nullptr};
+    // only accessed by the thread holding the lock
+    Node* owner = nullptr;
+
+public:
+    mcs_lock() {}
+    mcs_lock(mcs_lock const&) = delete;
+
+    void lock()
+    {
+        auto const n = pool().get();
+        auto const prev = tail.exchange(n, std::memory_order_acq_rel);
+        if(prev){
+            prev->next.store(n, std::memory_order_release);
+            unsigned spins = 0;
+            while(n->locked.load(std::memory_order_acquire)){
+                fn_::spin_wait(spins);
+            }
+        }
+        owner = n;
+    }
+
+    bool try_lock()
+    {
+        auto const n = pool().get();
+        Node* expected = nullptr;
+        if(tail.compare_exchange_strong(
+            expected, n,
+            std::memory_order_acquire, std::memory_order_relaxed
+        )){
+            owner = n;
+            return true;
+        }
+        pool().put(n);
+        return false;
+    }
+
+    void unlock()
+    {
+        auto const n = owner;
+        auto next = n->next.load(std::memory_order_acquire);
+        if(!next){
+            auto expected = n;
+            if(tail.compare_exchange_strong(
+                expected, static_cast<Node*>(nullptr),
+                std::memory_order_release, std::memory_order_relaxed
+            )){
+                pool().put(n);
+                return;
+            }
+            // a waiter is about to link itself behind n
+            unsigned spins = 0;
+            while(!(next = n->next.load(std::memory_order_acquire))){
+                fn_::spin_wait(spins);
+            }
+        }
+        next->locked.store(false, std::memory_order_release);
+        pool().put(n);
+    }
+};
+
+}
+
+#endif
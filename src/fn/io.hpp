@@ -0,0 +1,154 @@
+#ifndef _d41b8e7f_5a26_4c93_b1f0_92e7a3c6d058
+#define _d41b8e7f_5a26_4c93_b1f0_92e7a3c6d058
+
+/*
+ * Scatter/gather I/O over slices. POSIX only.
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "slice.hpp"
+
+namespace fn {
+
+namespace fn_ {
+
+#ifdef IOV_MAX
+static int const max_iovecs = IOV_MAX;
+#else
+static int const max_iovecs = 1024;
+#endif
+
+/*
+ * Walks a list of slices and keeps track of how much of them
+ * has been transferred, handing out the rest in iovec batches.
+ */
+template<typename S, typename It>
+class IoCursor
+{
+    It next;
+    It const end;
+    slice<S> current;
+
+    void skip_empty()
+    {
+        while(!current.size() && next != end){
+            current = *next;
+            ++next;
+        }
+    }
+
+public:
+    IoCursor(It const begin, It const end): next(begin), end(end)
+    {
+        skip_empty();
+    }
+
+    bool done() const { return !current.size(); }
+
+    int fill(iovec* const v) const
+    {
+        int n = 0;
+        if(done()){ return 0; }
+        v[n].iov_base = const_cast<void*>(static_cast<void const*>(current.data()));
+        v[n].iov_len = current.size();
+        ++n;
+        for(auto i = next; i != end && n < max_iovecs; ++i){
+            slice<S> const s = *i;
+            if(!s.size()){ continue; }
+            v[n].iov_base = const_cast<void*>(static_cast<void const*>(s.data()));
+            v[n].iov_len = s.size();
+            ++n;
+        }
+        return n;
+    }
+
+    void advance(size_t n)
+    {
+        while(n && !done() && n >= current.size()){
+            n -= current.size();
+            current = slice<S>();
+            skip_empty();
+        }
+        current = current.subslice(n);
+    }
+};
+
+// retries calls interrupted by signals
+template<typename F>
+ssize_t retry_eintr(F const& f)
+{
+    ssize_t r;
+    do{
+        r = f();
+    }while(r < 0 && errno == EINTR);
+    return r;
+}
+
+}
+
+namespace io {
+
+/*
+ * Writes all bytes of all slices to fd, in order, with as few writev
+ * calls as possible. Partial writes are continued where they stopped.
+ * Returns false if writev fails, with errno set; on a non-blocking fd
+ * this includes EAGAIN, after part of the data may have been written.
+ */
+template<typename Slices>
+bool write_all(int const fd, Slices const& slices)
+{
+    fn_::IoCursor<uint8_t const,decltype(slices.begin())> c(slices.begin(), slices.end());
+    iovec v[fn_::max_iovecs];
+    while(!c.done()){
+        auto const n = c.fill(v);
+        auto const r = fn_::retry_eintr([&]{ return ::writev(fd, v, n); });
+        if(r < 0){ return false; }
+        c.advance(size_t(r));
+    }
+    return true;
+}
+
+inline bool write_all(int const fd, std::initializer_list<slice<uint8_t const>> const slices)
+{
+    return write_all<std::initializer_list<slice<uint8_t const>>>(fd, slices);
+}
+
+/*
+ * Fills the slices from fd, in order, with as few readv calls as
+ * possible. Returns the number of bytes read, which is less than the
+ * size of the slices only at the end of the input, or nothing if
+ * readv fails, with errno set.
+ */
+template<typename Slices>
+optional<size_t> read_into(int const fd, Slices const& slices)
+{
+    fn_::IoCursor<uint8_t,decltype(slices.begin())> c(slices.begin(), slices.end());
+    iovec v[fn_::max_iovecs];
+    size_t total = 0;
+    while(!c.done()){
+        auto const n = c.fill(v);
+        auto const r = fn_::retry_eintr([&]{ return ::readv(fd, v, n); });
+        if(r < 0){ return {}; }
+        if(r == 0){ break; }
+        c.advance(size_t(r));
+        total += size_t(r);
+    }
+    return total;
+}
+
+inline optional<size_t> read_into(int const fd, std::initializer_list<slice<uint8_t>> const slices)
+{
+    return read_into<std::initializer_list<slice<uint8_t>>>(fd, slices);
+}
+
+}
+
+}
+
+#endif
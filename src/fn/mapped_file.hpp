@@ -0,0 +1,146 @@
+#ifndef _9b3f6c2e_1d4a_4e07_8c5b_a6d2e9f1074c
+#define _9b3f6c2e_1d4a_4e07_8c5b_a6d2e9f1074c
+
+/*
+ * Read only view of a whole file through the page cache. POSIX only.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "slice.hpp"
+
+namespace fn {
+
+/*
+ * Access pattern hints, passed on to madvise.
+ */
+enum class advice
+{
+    normal,
+    sequential,
+    random,
+    willneed,
+    dontneed,
+    hugepage,
+};
+
+/*
+ * Maps a file into memory and exposes its contents as a slice,
+ * without reading or copying anything up front:
+ *
+ *  mapped_file f("capture.bin");
+ *  f.advise(advice::sequential);
+ *  for(auto const& r: f.as<Record>()){ ... }
+ *
+ * The mapping is removed when the mapped_file is destroyed, so slices
+ * taken from it must not outlive it. Throws std::system_error if the
+ * file can not be opened or mapped.
+ */
+class mapped_file
+{
+    uint8_t const* _data = nullptr;
+    size_t _size = 0;
+
+    static std::system_error error(std::string const& what)
+    {
+        return std::system_error(errno, std::generic_category(), "fn::mapped_file: " + what);
+    }
+
+public:
+    explicit mapped_file(std::string const& path)
+    {
+        auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0){ throw error("open " + path); }
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            auto const e = error("stat " + path);
+            ::close(fd);
+            throw e;
+        }
+
+        _size = size_t(st.st_size);
+        if(_size){
+            auto const p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p == MAP_FAILED){
+                auto const e = error("mmap " + path);
+                ::close(fd);
+                throw e;
+            }
+            _data = static_cast<uint8_t const*>(p);
+        }
+        // the mapping stays valid without the descriptor
+        ::close(fd);
+    }
+
+    mapped_file(mapped_file&& o): _data(o._data), _size(o._size)
+    {
+        o._data = nullptr;
+        o._size = 0;
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    ~mapped_file()
+    {
+        if(_data){ ::munmap(const_cast<uint8_t*>(_data), _size); }
+    }
+
+    size_t size() const { return _size; }
+    uint8_t const* data() const { return _data; }
+
+    slice<uint8_t const> bytes() const { return slice<uint8_t const>(_data, _size); }
+
+    /*
+     * The contents as an array of R, trailing bytes that do not
+     * fill a whole R are left out.
+     */
+    template<typename R>
+    slice<R const> as() const
+    {
+        return bytes().template reinterpret_as<R const>();
+    }
+
+    /*
+     * Tells the kernel how the range will be accessed.
+     * The range is rounded out to whole pages.
+     * Returns false if the hint was rejected or is not supported.
+     */
+    bool advise(advice const a, size_t const offset=0, size_t length=size_t(-1)) const
+    {
+        if(!_data || offset >= _size){ return false; }
+        if(length > _size - offset){ length = _size - offset; }
+
+        int flag = MADV_NORMAL;
+        switch(a){
+        case advice::normal: flag = MADV_NORMAL; break;
+        case advice::sequential: flag = MADV_SEQUENTIAL; break;
+        case advice::random: flag = MADV_RANDOM; break;
+        case advice::willneed: flag = MADV_WILLNEED; break;
+        case advice::dontneed: flag = MADV_DONTNEED; break;
+        case advice::hugepage:
+#ifdef MADV_HUGEPAGE
+            flag = MADV_HUGEPAGE;
+            break;
+#else
+            return false;
+#endif
+        }
+
+        auto const page = size_t(::sysconf(_SC_PAGESIZE));
+        auto const begin = (offset / page) * page;
+        auto const base = const_cast<uint8_t*>(_data) + begin;
+        return ::madvise(base, offset + length - begin, flag) == 0;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef _6a1f9d3c_2e8b_4b70_9c64_d3b7e0a58f12
+#define _6a1f9d3c_2e8b_4b70_9c64_d3b7e0a58f12
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "iterators.hpp"
+#include "slice.hpp"
+
+namespace fn {
+
+namespace fn_ {
+
+/*
+ * Threads that wait for jobs made of numbered chunks. The thread
+ * that runs a job works on it as well, so a pool of n threads keeps
+ * n+1 cores busy. Jobs run one at a time; a job started from inside
+ * a chunk runs on the calling thread only, instead of deadlocking.
+ */
+class WorkPool
+{
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<std::thread> workers;
+    bool stop = false;
+
+    // only one job at a time
+    std::mutex running;
+
+    // the current job, guarded by mutex
+    std::function<void(size_t)> const* job = nullptr;
+    size_t chunks = 0;
+    size_t finished = 0;
+    size_t active = 0;
+    uint64_t generation = 0;
+    std::exception_ptr error;
+
+    std::atomic<size_t> next{0};
+
+    static bool& inside()
+    {
+        static thread_local bool in_pool = false;
+        return in_pool;
+    }
+
+    // claims chunks until none are left, called without the lock
+    void work(std::function<void(size_t)> const& f, size_t const count)
+    {
+        size_t done = 0;
+        std::exception_ptr e;
+        for(size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;){
+            try{
+                f(i);
+            }
+            catch(...){
+                if(!e){ e = std::current_exception(); }
+            }
+            ++done;
+        }
+
+        std::lock_guard<std::mutex> g(mutex);
+        if(e && !error){ error = e; }
+        finished += done;
+    }
+
+    void worker()
+    {
+        inside() = true;
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> l(mutex);
+        for(;;){
+            wake.wait(l, [&]{ return stop || (job && generation != seen); });
+            if(stop){ return; }
+            seen = generation;
+            auto const f = job;
+            auto const count = chunks;
+            ++active;
+            l.unlock();
+
+            work(*f, count);
+
+            l.lock();
+            --active;
+            idle.notify_all();
+        }
+    }
+
+public:
+    explicit WorkPool(size_t const threads)
+    {
+        for(size_t i = 0; i < threads; ++i){
+            workers.emplace_back([this]{ worker(); });
+        }
+    }
+
+    WorkPool(WorkPool const&) = delete;
+
+    ~WorkPool()
+    {
+        {
+            std::lock_guard<std::mutex> g(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for(auto& w: workers){ w.join(); }
+    }
+
+    size_t concurrency() const { return workers.size() + 1; }
+
+    /*
+     * Calls f(i) for every i in [0,count), spread over the pool, and
+     * returns when all calls have returned. Rethrows the first exception
+     * thrown by f.
+     */
+    void run(size_t const count, std::function<void(size_t)> const& f)
+    {
+        if(inside() || workers.empty() || count < 2){
+            for(size_t i = 0; i < count; ++i){ f(i); }
+            return;
+        }
+
+        std::lock_guard<std::mutex> r(running);
+        {
+            std::lock_guard<std::mutex> g(mutex);
+            job = &f;
+            chunks = count;
+            finished = 0;
+            error = nullptr;
+            next.store(0, std::memory_order_relaxed);
+            ++generation;
+        }
+        wake.notify_all();
+
+        inside() = true;
+        work(f, count);
+        inside() = false;
+
+        std::unique_lock<std::mutex> l(mutex);
+        idle.wait(l, [&]{ return finished == chunks && active == 0; });
+        job = nullptr;
+        auto const e = error;
+        error = nullptr;
+        l.unlock();
+
+        if(e){ std::rethrow_exception(e); }
+    }
+};
+
+inline WorkPool& work_pool()
+{
+    static WorkPool p(std::max(1U, std::thread::hardware_concurrency()) - 1);
+    return p;
+}
+
+/*
+ * Default number of elements per chunk: 64KB worth of elements,
+ * enough to hide the cost of handing out the chunk.
+ */
+template<typename T>
+constexpr size_t parallel_chunk()
+{
+    return sizeof(T) >= 64*1024 ? 1 : 64*1024/sizeof(T);
+}
+
+template<typename T>
+slice<T> chunk_of(slice<T> const s, size_t const i, size_t const chunk)
+{
+    auto const rest = s.subslice(i*chunk);
+    return rest.first(std::min(chunk, rest.size()));
+}
+
+}
+
+/*
+ * Calls f with every element of s, splitting s into chunks of
+ * chunk elements that are processed in parallel. The order of
+ * the calls is unspecified.
+ */
+template<typename T, typename F>
+void parallel_for_each(slice<T> const s, F const& f, size_t chunk=fn_::parallel_chunk<T>())
+{
+    chunk = std::max<size_t>(chunk, 1);
+    fn_::work_pool().run((s.size() + chunk - 1)/chunk, [&](size_t const i){
+        for(auto& x: fn_::chunk_of(s, i, chunk)){
+            f(x);
+        }
+    });
+}
+
+/*
+ * Reduces every chunk of s with op, starting from neutral, in parallel,
+ * then combines the results of the chunks in order. The chunks depend
+ * on the chunk size only, so the result is the same for any number of
+ * threads, even for operations like floating point addition.
+ */
+template<typename T, typename R, typename Op, typename Combine>
+R parallel_reduce(
+    slice<T> const s,
+    R const& neutral,
+    Op const& op,
+    Combine const& combine,
+    size_t chunk=fn_::parallel_chunk<T>()
+)
+{
+    chunk = std::max<size_t>(chunk, 1);
+    std::vector<R> partial((s.size() + chunk - 1)/chunk, neutral);
+    fn_::work_pool().run(partial.size(), [&](size_t const i){
+        partial[i] = reduce(fn_::chunk_of(s, i, chunk), neutral, op);
+    });
+    return reduce(partial, neutral, combine);
+}
+
+template<typename T, typename R, typename Op>
+R parallel_reduce(slice<T> const s, R const& neutral, Op const& op)
+{
+    return parallel_reduce(s, neutral, op, op);
+}
+
+}
+
+#endif
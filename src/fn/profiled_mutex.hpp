@@ -0,0 +1,281 @@
+#ifndef _1ce29fc9_e84b_477d_aef9_e5c2975e65a7
+#define _1ce29fc9_e84b_477d_aef9_e5c2975e65a7
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "synchronized.hpp"
+
+#ifdef __GNUC__
+#define FN_NOINLINE __attribute__((noinline))
+#define FN_CALLER __builtin_return_address(0)
+#else
+#define FN_NOINLINE
+#define FN_CALLER nullptr
+#endif
+
+namespace fn {
+
+/*
+ * Snapshot of the statistics gathered by a profiled mutex.
+ * Bucket i of a histogram counts durations of less than 2^i nanoseconds
+ * that did not fit into bucket i-1; the last bucket takes everything else.
+ */
+struct lock_stats
+{
+    static size_t const buckets = 32;
+
+    char const* name;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_ns;
+    uint64_t hold_ns;
+    uint64_t max_wait_ns;
+    void const* max_wait_site;
+    uint64_t wait_histogram[buckets];
+    uint64_t hold_histogram[buckets];
+};
+
+namespace fn_ {
+
+/*
+ * Counter that is only ever modified while the profiled mutex is held,
+ * so it needs no atomic read-modify-write. It is atomic nevertheless,
+ * because the registry reads it from other threads.
+ */
+struct LockCounter
+{
+    std::atomic<uint64_t> v{0};
+
+    void add(uint64_t const x)
+    {
+        v.store(v.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t const x) { v.store(x, std::memory_order_relaxed); }
+
+    uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+inline size_t histogram_bucket(uint64_t ns)
+{
+    size_t b = 0;
+    while(ns && b < lock_stats::buckets-1){
+        ns >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+class LockProfile;
+
+class LockRegistry
+{
+    std::mutex mutex;
+    std::vector<LockProfile*> profiles;
+
+public:
+    void add(LockProfile* p)
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        profiles.push_back(p);
+    }
+
+    void remove(LockProfile* p)
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        profiles.erase(std::remove(profiles.begin(), profiles.end(), p), profiles.end());
+    }
+
+    template<typename F>
+    void for_all(F const& f)
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        for(auto p: profiles){ f(*p); }
+    }
+};
+
+inline LockRegistry& lock_registry()
+{
+    static LockRegistry r;
+    return r;
+}
+
+class LockProfile
+{
+    std::atomic<char const*> _name;
+    LockCounter acquisitions;
+    LockCounter contended;
+    LockCounter wait_ns;
+    LockCounter hold_ns;
+    LockCounter max_wait_ns;
+    std::atomic<void const*> max_wait_site;
+    LockCounter wait_histogram[lock_stats::buckets];
+    LockCounter hold_histogram[lock_stats::buckets];
+
+protected:
+    LockProfile(char const* name):
+        _name(name),
+        max_wait_site(nullptr)
+    {
+        lock_registry().add(this);
+    }
+
+    ~LockProfile() { lock_registry().remove(this); }
+
+    void acquired(uint64_t const wait, void const* site)
+    {
+        acquisitions.add(1);
+        if(wait){
+            contended.add(1);
+            wait_ns.add(wait);
+            wait_histogram[histogram_bucket(wait)].add(1);
+            if(wait > max_wait_ns.get()){
+                max_wait_ns.set(wait);
+                max_wait_site.store(site, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void released(uint64_t const hold)
+    {
+        hold_ns.add(hold);
+        hold_histogram[histogram_bucket(hold)].add(1);
+    }
+
+public:
+    LockProfile(LockProfile const&) = delete;
+
+    void name(char const* n) { _name.store(n); }
+
+    lock_stats stats() const
+    {
+        lock_stats s;
+        s.name = _name.load();
+        s.acquisitions = acquisitions.get();
+        s.contended = contended.get();
+        s.wait_ns = wait_ns.get();
+        s.hold_ns = hold_ns.get();
+        s.max_wait_ns = max_wait_ns.get();
+        s.max_wait_site = max_wait_site.load(std::memory_order_relaxed);
+        for(size_t i = 0; i < lock_stats::buckets; ++i){
+            s.wait_histogram[i] = wait_histogram[i].get();
+            s.hold_histogram[i] = hold_histogram[i].get();
+        }
+        return s;
+    }
+};
+
+}
+
+/*
+ * Mutex wrapper that records how often and how long it is waited for
+ * and held. Use it as the Mutex of synchronized or guard to find hot locks:
+ *
+ *  synchronized<Accounts,profiled<>> accounts;
+ *  accounts.get_mutex().name("accounts");
+ *  ...
+ *  dump_lock_stats(std::cerr);
+ *
+ * An acquisition counts as contended if the mutex was not available
+ * immediately. For the longest wait the return address of the lock call
+ * is kept (gcc/clang only), which points into the function that locked.
+ */
+template<typename Mutex=std::mutex>
+class profiled : public fn_::LockProfile
+{
+    typedef std::chrono::steady_clock clock;
+
+    Mutex mutex;
+    clock::time_point since;
+
+    static uint64_t ns(clock::duration const d)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+public:
+    explicit profiled(char const* name=nullptr): fn_::LockProfile(name) {}
+
+    FN_NOINLINE void lock()
+    {
+        if(fn::try_lock(mutex)){
+            since = clock::now();
+            acquired(0, FN_CALLER);
+            return;
+        }
+        auto const start = clock::now();
+        fn::lock(mutex);
+        since = clock::now();
+        // a wait of zero is not possible, as the lock was busy
+        acquired(std::max<uint64_t>(ns(since - start), 1), FN_CALLER);
+    }
+
+    bool try_lock()
+    {
+        if(!fn::try_lock(mutex)){ return false; }
+        since = clock::now();
+        acquired(0, FN_CALLER);
+        return true;
+    }
+
+    void unlock()
+    {
+        released(ns(clock::now() - since));
+        fn::unlock(mutex);
+    }
+};
+
+/*
+ * Statistics of all currently existing profiled mutexes.
+ */
+inline std::vector<lock_stats> lock_stats_all()
+{
+    std::vector<lock_stats> r;
+    fn_::lock_registry().for_all([&](fn_::LockProfile const& p){
+        r.push_back(p.stats());
+    });
+    return r;
+}
+
+/*
+ * Writes a human readable report of all profiled mutexes,
+ * most contended first.
+ */
+inline void dump_lock_stats(std::ostream& out)
+{
+    auto all = lock_stats_all();
+    std::sort(all.begin(), all.end(), [](lock_stats const& a, lock_stats const& b){
+        return a.wait_ns > b.wait_ns;
+    });
+
+    auto histogram = [&](char const* what, uint64_t const* h){
+        out << "  " << what << ":";
+        for(size_t i = 0; i < lock_stats::buckets; ++i){
+            if(h[i]){ out << " <" << (uint64_t(1) << i) << "ns:" << h[i]; }
+        }
+        out << "\n";
+    };
+
+    for(auto const& s: all){
+        out << (s.name ? s.name : "(unnamed)")
+            << ": " << s.acquisitions << " acquisitions, "
+            << s.contended << " contended, "
+            << "wait " << s.wait_ns << "ns (max " << s.max_wait_ns << "ns at "
+            << s.max_wait_site << "), "
+            << "hold " << s.hold_ns << "ns\n";
+        histogram("wait", s.wait_histogram);
+        histogram("hold", s.hold_histogram);
+    }
+}
+
+}
+
+#undef FN_NOINLINE
+#undef FN_CALLER
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef _71826e80_725b_40b9_a92f_a21d988d54b9
+#define _71826e80_725b_40b9_a92f_a21d988d54b9
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include "iterators.hpp"
+
+namespace fn {
+
+namespace fn_ {
+
+/*
+ * Hands out small, dense indices to threads.
+ * The index of a thread that exits is reused by the next new thread.
+ */
+class ThreadIndices
+{
+    std::mutex mutex;
+    std::vector<size_t> free;
+    size_t next = 0;
+
+public:
+    size_t acquire()
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        if(free.empty()){ return next++; }
+        auto const i = free.back();
+        free.pop_back();
+        return i;
+    }
+
+    void release(size_t const i)
+    {
+        std::lock_guard<std::mutex> g(mutex);
+        free.push_back(i);
+    }
+};
+
+inline ThreadIndices& thread_indices()
+{
+    static ThreadIndices t;
+    return t;
+}
+
+struct ThreadIndex
+{
+    size_t const index;
+    ThreadIndex(): index(thread_indices().acquire()) {}
+    ~ThreadIndex() { thread_indices().release(index); }
+};
+
+inline size_t thread_index()
+{
+    static thread_local ThreadIndex i;
+    return i.index;
+}
+
+}
+
+/*
+ * An accumulator with one instance per thread, each on its own
+ * cache line, so that updates from different threads never touch
+ * the same memory:
+ *
+ *  sharded<uint64_t> hits;
+ *  hits >>[](uint64_t& h){ ++h; };   // hot path, core local
+ *  auto total = hits.collect();       // combines all instances
+ *
+ * Every instance starts as a copy of neutral, collect() reduces them
+ * with combine. An instance is only ever locked by its own thread
+ * and by collect(), so updates do not contend with each other.
+ */
+template<typename T, typename Combine=std::plus<T>>
+class sharded
+{
+    struct alignas(fn_::cache_line_size) Slot
+    {
+        std::atomic<bool> busy;
+        T value;
+
+        Slot(T const& value): busy(false), value(value) {}
+    };
+
+    struct Lock
+    {
+        Slot& s;
+
+        Lock(Slot& s): s(s)
+        {
+            while(s.busy.exchange(true, std::memory_order_acquire)){
+                std::this_thread::yield();
+            }
+        }
+
+        ~Lock() { s.busy.store(false, std::memory_order_release); }
+    };
+
+    static size_t const segment_size = 64;
+    static size_t const max_segments = 64;
+
+    T const neutral;
+    Combine const combine;
+    std::atomic<Slot*> segments[max_segments];
+
+    // Segments are over-allocated and aligned by hand, as operator new
+    // does not respect the alignment of Slot before C++17.
+    // The pointer to free is stored right in front of the first slot.
+    Slot* allocate()
+    {
+        auto const raw = new unsigned char[
+            segment_size*sizeof(Slot) + fn_::cache_line_size + sizeof(unsigned char*)
+        ];
+        auto const addr = reinterpret_cast<uintptr_t>(raw + sizeof(unsigned char*));
+        auto const aligned = reinterpret_cast<unsigned char*>(
+            (addr + fn_::cache_line_size - 1) & ~(uintptr_t(fn_::cache_line_size) - 1)
+        );
+        reinterpret_cast<unsigned char**>(aligned)[-1] = raw;
+
+        auto const slots = reinterpret_cast<Slot*>(aligned);
+        for(size_t i = 0; i < segment_size; ++i){
+            new (slots+i) Slot(neutral);
+        }
+        return slots;
+    }
+
+    static void release(Slot* const slots)
+    {
+        for(size_t i = 0; i < segment_size; ++i){
+            slots[i].~Slot();
+        }
+        delete[] reinterpret_cast<unsigned char**>(slots)[-1];
+    }
+
+    Slot& local()
+    {
+        auto const i = fn_::thread_index();
+        auto const n = i / segment_size;
+        if(n >= max_segments){
+            throw std::length_error("fn::sharded: too many threads");
+        }
+
+        auto s = segments[n].load(std::memory_order_acquire);
+        if(!s){
+            auto const fresh = allocate();
+            if(segments[n].compare_exchange_strong(s, fresh, std::memory_order_acq_rel)){
+                s = fresh;
+            }
+            else{
+                release(fresh);
+            }
+        }
+        return s[i % segment_size];
+    }
+
+public:
+    explicit sharded(T const& neutral=T(), Combine const& combine=Combine()):
+        neutral(neutral),
+        combine(combine)
+    {
+        for(auto& s: segments){ s.store(nullptr); }
+    }
+
+    sharded(sharded const&) = delete;
+
+    ~sharded()
+    {
+        for(auto& s: segments){
+            auto const p = s.load();
+            if(p){ release(p); }
+        }
+    }
+
+    /*
+     * Applies f to the instance of the calling thread.
+     */
+    template<typename F>
+    void operator>>(F const& f)
+    {
+        auto& s = local();
+        Lock l(s);
+        f(s.value);
+    }
+
+    /*
+     * Combines the instances of all threads.
+     */
+    T collect() const
+    {
+        std::vector<T> values;
+        for(auto& segment: segments){
+            auto const p = segment.load(std::memory_order_acquire);
+            if(!p){ continue; }
+            for(size_t i = 0; i < segment_size; ++i){
+                Lock l(p[i]);
+                values.push_back(p[i].value);
+            }
+        }
+        return reduce(values, neutral, combine);
+    }
+};
+
+}
+
+#endif
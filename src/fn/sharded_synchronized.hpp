@@ -0,0 +1,97 @@
+#ifndef _205d47dd_3988_429e_956d_c299a5605a6f
+#define _205d47dd_3988_429e_956d_c299a5605a6f
+
+#include <mutex>
+#include <functional>
+#include "common.hpp"
+#include "synchronized.hpp"
+
+namespace fn {
+
+/*
+ * A map split into N independently locked shards.
+ * Each key is hashed to one shard, so threads working on different
+ * keys rarely contend for the same mutex:
+ *
+ *  sessions[id] >>[&](Map& m){ m[id] = s; };
+ *
+ * Every shard lives on its own cache line.
+ */
+template<
+    typename Map,
+    size_t N,
+    typename Mutex=std::mutex,
+    typename Hash=std::hash<typename Map::key_type>
+>
+class sharded_synchronized final
+{
+    static_assert(N > 0, "fn::sharded_synchronized: need at least one shard");
+
+    struct alignas(fn_::cache_line_size) Shard
+    {
+        synchronized<Map,Mutex> value;
+    };
+
+    Shard shards[N];
+
+    template<typename M, typename S, typename F>
+    static void visit(S& shards, M** maps, size_t const i, F const& f)
+    {
+        if(i == N){
+            for(size_t j = 0; j < N; ++j){
+                f(*maps[j]);
+            }
+            return;
+        }
+        shards[i].value >>[&](M& m){
+            maps[i] = &m;
+            visit<M>(shards, maps, i+1, f);
+        };
+    }
+
+public:
+    using Type = Map;
+    using Key = typename Map::key_type;
+
+    static size_t index(Key const& key)
+    {
+        // spread the bits, std::hash is the identity for integers
+        auto h = static_cast<size_t>(Hash()(key));
+        h ^= h >> 15;
+        h *= 0x2c1b3c6dU;
+        h ^= h >> 12;
+        return h % N;
+    }
+
+    synchronized<Map,Mutex>& operator[](Key const& key)
+    {
+        return shards[index(key)].value;
+    }
+
+    synchronized<Map,Mutex> const& operator[](Key const& key) const
+    {
+        return shards[index(key)].value;
+    }
+
+    /*
+     * Locks all shards (always in the same order) and calls f
+     * on each of them, giving a consistent view of the whole map.
+     */
+    template<typename F>
+    void for_all(F const& f)
+    {
+        Map* maps[N];
+        visit<Map>(shards, maps, 0, f);
+    }
+
+    template<typename F>
+    void for_all(F const& f) const
+    {
+        Map const* maps[N];
+        visit<Map const>(shards, maps, 0, f);
+    }
+};
+
+}
+
+#endif
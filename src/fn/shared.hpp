@@ -1,38 +1,56 @@
 #ifndef _ad03a310_3d97_4841_a98d_7b7a65870185
 #define _ad03a310_3d97_4841_a98d_7b7a65870185
 
+#include <atomic>
+#include <cstdint>
+#include <thread>
 #include "optional.hpp"
 
 namespace fn {
 
 namespace fn_ {
 
+/*
+ * Node of a ring of objects that know each other. Once a ring has more
+ * than one member, its members share a head that keeps the number of
+ * members and an epoch. Every node carries the epoch it was created
+ * with, so a whole ring is invalidated at once by advancing the epoch
+ * of its head; the nodes notice lazily, when they check current().
+ */
 struct chained
 {
-    chained(): prev(this), next(this) {}
+    chained(): prev(this), next(this), head(nullptr), stamp(0) {}
 
     chained(chained& o):
         prev(&o),
-        next(o.next)
+        next(o.next),
+        head(o.shared_head()),
+        stamp(o.stamp)
     {
         prev->next = this;
         next->prev = this;
+        ++head->count;
     }
 
     chained(chained&& o):
         prev(o.prev),
-        next(o.next)
+        next(o.next),
+        head(o.head),
+        stamp(o.stamp)
     {
         prev->next = this;
         next->prev = this;
         o.prev = &o;
         o.next = &o;
+        o.head = nullptr;
+        o.stamp = 0;
     }
 
     ~chained()
     {
         prev->next = next;
         next->prev = prev;
+        if(head && --head->count == 0){ delete head; }
     }
 
     template<typename F>
@@ -45,33 +63,73 @@ struct chained
         } while(cur != this);
     }
 
-    size_t count()
-    {
-        size_t c = 0;
-        for_all([&](chained&){ ++c; });
-        return c;
-    }
+    size_t count() const { return head ? head->count : 1; }
+
+    /*
+     * Marks all members of the ring as outdated, without visiting them.
+     * Members that join later through an outdated one are outdated too.
+     */
+    void invalidate_all() { ++shared_head()->epoch; }
+
+    bool current() const { return !head || head->epoch == stamp; }
 
 private:
+    struct Head
+    {
+        size_t count;
+        uint32_t epoch;
+    };
+
     chained* prev;
     chained* next;
+    Head* head;
+    uint32_t stamp;
+
+    Head* shared_head()
+    {
+        if(!head){ head = new Head{1,stamp}; }
+        return head;
+    }
 };
 
 }
 
-template<typename T> struct ref;
+/*
+ * Storage modes of shared<T> and ref<T>:
+ *
+ * ref_chain: every ref points at the value directly, all refs of a
+ *            value are linked in a ring. Moving the shared value visits
+ *            every ref, destroying it only advances the epoch of the ring,
+ *            which refs check on access.
+ *
+ * ref_cell:  refs point at a small control cell that points at the value.
+ *            Access needs one more indirection, but moving or destroying
+ *            the shared value updates only the cell.
+ *
+ * ref_atomic: like ref_cell, but refs may be created, copied and
+ *            destroyed from any thread. The value is accessed through
+ *            a pin, which keeps the shared value from being destroyed
+ *            or moved while it exists.
+ */
+struct ref_chain {};
+struct ref_cell {};
+struct ref_atomic {};
 
-template<typename T>
+template<typename T, typename Storage=ref_chain> struct ref;
+
+template<typename T, typename Storage=ref_chain>
 struct shared
 {
     explicit shared(T const& value): value(value) { }
 
     shared(shared&& o): value(fn_::move(o.value)), refs(fn_::move(o.refs))
     {
-        refs >>[this](ref<T>& refs) {
-            refs.retarget(this->value);
-        };
-        o.refs = {};
+        auto const anchor = &refs;
+        refs.for_all([&](fn_::chained& x){
+            if(&x != anchor){
+                static_cast<ref<T,Storage>&>(x).value = &value;
+            }
+        });
     }
 
     shared(shared const&) = delete;
@@ -85,9 +143,7 @@ struct shared
 
     ~shared()
     {
-        refs >>[](ref<T>& refs) {
-            refs.invalidate();
-        };
+        if(refs.count() > 1){ refs.invalidate_all(); }
     }
 
     operator T& () { return value; }
@@ -95,36 +151,412 @@ struct shared
 private:
     T value;
 
-    friend struct ref<T>;
-    optional<ref<T>&> refs;
+    friend struct ref<T,Storage>;
+    // member of the ring of refs, so the ring never loses its shared value
+    fn_::chained refs;
 };
 
+template<typename T, typename Storage>
+struct ref : private fn_::chained
+{
+    ref(): value(nullptr) {}
+    ref(shared<T,Storage>& o): fn_::chained(o.refs), value(&o.value) {}
+
+    optional<T&> get() const
+    {
+        if(value && current()){
+            return *value;
+        }
+        return {};
+    }
+
+    bool valid() const { return get().valid(); }
+
+    template<typename F>
+    auto operator>>(F const& f) const -> decltype(get() >> f)
+    {
+        return get() >> f;
+    }
+
+    template<typename F>
+    auto operator||(F const& f) const -> decltype(get() || f)
+    {
+        return get() || f;
+    }
+
+    template<typename F>
+    T operator|(F const& fallback) const
+    {
+        return get() | fallback;
+    }
+
+    T operator~() const { return ~get(); }
+
+private:
+    friend struct shared<T,Storage>;
+    T* value;
+};
+
+// gcc 12 can not follow the reference count and reports a use after free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuse-after-free"
+#endif
+
+namespace fn_ {
+
 template<typename T>
-struct ref : private fn_::chained, public optional<T&>
+struct Cell
 {
-    ref() {}
-    ref(shared<T>& o): optional<T&>(o.value)
+    T* value;
+    // number of refs, plus one for the shared value while it exists
+    size_t count;
+
+    static void release(Cell* const c)
     {
-        o.refs = *this;
+        if(c && --c->count == 0){ delete c; }
     }
+};
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+
+template<typename T>
+struct shared<T,ref_cell>
+{
+    explicit shared(T const& value): value(value), cell(nullptr) { }
+
+    shared(shared&& o): value(fn_::move(o.value)), cell(o.cell)
+    {
+        if(cell){ cell->value = &value; }
+        o.cell = nullptr;
+    }
+
+    shared(shared const&) = delete;
+    shared& operator=(shared const&) = delete;
+
+    shared& operator=(T const& v)
+    {
+        value = v;
+        return *this;
+    }
+
+    ~shared()
+    {
+        if(cell){ cell->value = nullptr; }
+        fn_::Cell<T>::release(cell);
+    }
+
+    operator T& () { return value; }
 
 private:
-    friend struct shared<T>;
-    void retarget(T& value)
+    T value;
+
+    friend struct ref<T,ref_cell>;
+    // created when the first ref is taken
+    fn_::Cell<T>* cell;
+
+    fn_::Cell<T>* get_cell()
     {
-        for_all([&](fn_::chained& x){
-            auto& r = static_cast<ref&>(x);
-            static_cast<optional<T&>&>(r) = value;
-        });
+        if(!cell){ cell = new fn_::Cell<T>{&value,1}; }
+        return cell;
     }
+};
 
-    void invalidate()
+template<typename T>
+struct ref<T,ref_cell>
+{
+    ref(): cell(nullptr) {}
+
+    ref(shared<T,ref_cell>& o): cell(o.get_cell())
     {
-        for_all([](fn_::chained& x){
-            auto& r = static_cast<ref&>(x);
-            static_cast<optional<T&>&>(r) = {};
-        });
+        ++cell->count;
+    }
+
+    ref(ref const& o): cell(o.cell)
+    {
+        if(cell){ ++cell->count; }
+    }
+
+    ref& operator=(ref const& o)
+    {
+        if(o.cell){ ++o.cell->count; }
+        fn_::Cell<T>::release(cell);
+        cell = o.cell;
+        return *this;
     }
+
+    ~ref() { fn_::Cell<T>::release(cell); }
+
+    optional<T&> get() const
+    {
+        if(cell && cell->value){
+            return *cell->value;
+        }
+        return {};
+    }
+
+    bool valid() const { return get().valid(); }
+
+    template<typename F>
+    auto operator>>(F const& f) const -> decltype(get() >> f)
+    {
+        return get() >> f;
+    }
+
+    template<typename F>
+    auto operator||(F const& f) const -> decltype(get() || f)
+    {
+        return get() || f;
+    }
+
+    template<typename F>
+    T operator|(F const& fallback) const
+    {
+        return get() | fallback;
+    }
+
+    T operator~() const { return ~get(); }
+
+private:
+    fn_::Cell<T>* cell;
+};
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuse-after-free"
+#endif
+
+namespace fn_ {
+
+template<typename T>
+struct AtomicCell
+{
+    static uint32_t const dead = 1U << 31;
+    static uint32_t const moving = 1U << 30;
+    static uint32_t const pins = moving - 1;
+
+    T* value;
+    // flags and number of pins
+    std::atomic<uint32_t> state;
+    // number of refs, plus one for the shared value while it exists
+    std::atomic<size_t> count;
+
+    AtomicCell(T* value): value(value), state(0), count(1) {}
+
+    // sets flag and waits until all pins are gone
+    void close(uint32_t const flag)
+    {
+        state.fetch_or(flag, std::memory_order_acq_rel);
+        while(state.load(std::memory_order_acquire) & pins){
+            std::this_thread::yield();
+        }
+    }
+
+    T* pin()
+    {
+        for(;;){
+            auto const s = state.fetch_add(1, std::memory_order_acquire);
+            if(!(s & (dead|moving))){ return value; }
+            state.fetch_sub(1, std::memory_order_release);
+            if(s & dead){ return nullptr; }
+            std::this_thread::yield();
+        }
+    }
+
+    void unpin() { state.fetch_sub(1, std::memory_order_release); }
+
+    static void release(AtomicCell* const c)
+    {
+        if(c && c->count.fetch_sub(1, std::memory_order_acq_rel) == 1){ delete c; }
+    }
+};
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+
+/*
+ * Access to a value shared with ref_atomic storage.
+ * As long as the pin is valid, the value stays where it is.
+ */
+template<typename T>
+class pinned
+{
+    fn_::AtomicCell<T>* cell;
+    T* value;
+
+public:
+    explicit pinned(fn_::AtomicCell<T>* const cell):
+        cell(cell),
+        value(cell ? cell->pin() : nullptr)
+    {}
+
+    pinned(pinned const&) = delete;
+
+    pinned(pinned&& o): cell(o.cell), value(o.value)
+    {
+        o.value = nullptr;
+    }
+
+    ~pinned() { if(value){ cell->unpin(); } }
+
+    optional<T&> get() const
+    {
+        if(value){ return *value; }
+        return {};
+    }
+
+    bool valid() const { return !!value; }
+
+    template<typename F>
+    auto operator>>(F const& f) const -> decltype(get() >> f)
+    {
+        return get() >> f;
+    }
+
+    template<typename F>
+    auto operator||(F const& f) const -> decltype(get() || f)
+    {
+        return get() || f;
+    }
+
+    template<typename F>
+    T operator|(F const& fallback) const
+    {
+        return get() | fallback;
+    }
+
+    T operator~() const { return ~get(); }
+};
+
+template<typename T>
+struct shared<T,ref_atomic>
+{
+    explicit shared(T const& value): value(value), cell(nullptr) { }
+
+    shared(shared&& o):
+        value(fn_::move(o.closed().value)),
+        cell(o.cell.exchange(nullptr))
+    {
+        auto const c = cell.load();
+        if(c){
+            c->value = &value;
+            c->state.fetch_and(~fn_::AtomicCell<T>::moving, std::memory_order_release);
+        }
+    }
+
+    shared(shared const&) = delete;
+    shared& operator=(shared const&) = delete;
+
+    shared& operator=(T const& v)
+    {
+        value = v;
+        return *this;
+    }
+
+    /*
+     * Waits until no pins are left, after that all refs are invalid.
+     */
+    ~shared()
+    {
+        auto const c = cell.load();
+        if(c){
+            c->close(fn_::AtomicCell<T>::dead);
+            fn_::AtomicCell<T>::release(c);
+        }
+    }
+
+    operator T& () { return value; }
+
+private:
+    T value;
+
+    friend struct ref<T,ref_atomic>;
+    // created when the first ref is taken
+    std::atomic<fn_::AtomicCell<T>*> cell;
+
+    shared& closed()
+    {
+        auto const c = cell.load();
+        if(c){ c->close(fn_::AtomicCell<T>::moving); }
+        return *this;
+    }
+
+    // returns the cell with its count already incremented for the caller
+    fn_::AtomicCell<T>* acquire_cell()
+    {
+        auto c = cell.load(std::memory_order_acquire);
+        if(!c){
+            auto const fresh = new fn_::AtomicCell<T>(&value);
+            if(cell.compare_exchange_strong(c, fresh, std::memory_order_acq_rel)){
+                c = fresh;
+            }
+            else{
+                delete fresh;
+            }
+        }
+        c->count.fetch_add(1, std::memory_order_relaxed);
+        return c;
+    }
+};
+
+template<typename T>
+struct ref<T,ref_atomic>
+{
+    ref(): cell(nullptr) {}
+
+    ref(shared<T,ref_atomic>& o): cell(o.acquire_cell()) {}
+
+    ref(ref const& o): cell(o.cell)
+    {
+        if(cell){ cell->count.fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    ref& operator=(ref const& o)
+    {
+        if(o.cell){ o.cell->count.fetch_add(1, std::memory_order_relaxed); }
+        fn_::AtomicCell<T>::release(cell);
+        cell = o.cell;
+        return *this;
+    }
+
+    ~ref() { fn_::AtomicCell<T>::release(cell); }
+
+    pinned<T> pin() const { return pinned<T>(cell); }
+
+    bool valid() const { return pin().valid(); }
+
+    /*
+     * Calls f with the value pinned for the duration of the call.
+     */
+    template<typename F>
+    auto operator>>(F const& f) const -> decltype(pin() >> f)
+    {
+        return pin() >> f;
+    }
+
+    template<typename F>
+    auto operator||(F const& f) const -> decltype(pin() || f)
+    {
+        return pin() || f;
+    }
+
+    template<typename F>
+    T operator|(F const& fallback) const
+    {
+        return pin() | fallback;
+    }
+
+    T operator~() const { return ~pin(); }
+
+private:
+    fn_::AtomicCell<T>* cell;
 };
 
 }
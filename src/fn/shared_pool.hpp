@@ -0,0 +1,148 @@
+#ifndef _e2b7d1a4_6f3c_4d85_9a0e_7c41b58f2d63
+#define _e2b7d1a4_6f3c_4d85_9a0e_7c41b58f2d63
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "shared.hpp"
+
+namespace fn {
+
+/*
+ * Arena for shared values that are created and destroyed at a high rate.
+ * Values are constructed in place in slabs of SlabSize slots, freed slots
+ * are reused before new slabs are allocated, so values created together
+ * stay close to each other in memory:
+ *
+ *  shared_pool<Node> nodes;
+ *  auto& n = nodes.make(Node(...));
+ *  ref<Node> r(n);
+ *  nodes.destroy(n);   // r is invalid now
+ *
+ * Values never move once created. Destroying the pool destroys all
+ * values that are still alive, invalidating their refs, and releases
+ * the slabs as a whole.
+ */
+template<typename T, typename Storage=ref_chain, size_t SlabSize=64>
+class shared_pool
+{
+public:
+    typedef shared<T,Storage> value_type;
+
+private:
+    struct Slot
+    {
+        union
+        {
+            typename std::aligned_storage<sizeof(value_type),alignof(value_type)>::type storage;
+            Slot* next;
+        };
+        bool live;
+
+        value_type& value() { return *reinterpret_cast<value_type*>(&storage); }
+    };
+
+    struct Slab
+    {
+        Slot slots[SlabSize];
+    };
+
+    std::vector<std::unique_ptr<Slab>> slabs;
+    Slot* free_slots = nullptr;
+    size_t live = 0;
+
+    Slot* acquire()
+    {
+        if(!free_slots){
+            slabs.emplace_back(new Slab);
+            auto& slab = *slabs.back();
+            // chained in order, so consecutive allocations are adjacent
+            for(size_t i = SlabSize; i > 0; --i){
+                slab.slots[i-1].live = false;
+                slab.slots[i-1].next = free_slots;
+                free_slots = &slab.slots[i-1];
+            }
+        }
+        auto const s = free_slots;
+        free_slots = s->next;
+        return s;
+    }
+
+    void release(Slot* const s)
+    {
+        s->value().~value_type();
+        s->live = false;
+        s->next = free_slots;
+        free_slots = s;
+        --live;
+    }
+
+    // the value is the first member of its slot
+    static Slot* slot_of(value_type& v) { return reinterpret_cast<Slot*>(&v); }
+
+public:
+    shared_pool() {}
+    shared_pool(shared_pool const&) = delete;
+    shared_pool& operator=(shared_pool const&) = delete;
+
+    ~shared_pool() { clear(); }
+
+    template<typename ...Args>
+    value_type& make(Args&&... args)
+    {
+        auto const s = acquire();
+        try{
+            new (&s->storage) value_type(T(std::forward<Args>(args)...));
+        }
+        catch(...){
+            s->next = free_slots;
+            free_slots = s;
+            throw;
+        }
+        s->live = true;
+        ++live;
+        return s->value();
+    }
+
+    /*
+     * Destroys a value created by this pool, its refs become invalid.
+     */
+    void destroy(value_type& v) { release(slot_of(v)); }
+
+    /*
+     * Calls f for all values, in the order in which they are laid out.
+     */
+    template<typename F>
+    void for_all(F f)
+    {
+        for(auto& slab: slabs){
+            for(auto& s: slab->slots){
+                if(s.live){ f(s.value()); }
+            }
+        }
+    }
+
+    /*
+     * Destroys all values and releases all slabs.
+     */
+    void clear()
+    {
+        for(auto& slab: slabs){
+            for(auto& s: slab->slots){
+                if(s.live){ s.value().~value_type(); }
+            }
+        }
+        slabs.clear();
+        free_slots = nullptr;
+        live = 0;
+    }
+
+    size_t size() const { return live; }
+    size_t capacity() const { return slabs.size() * SlabSize; }
+};
+
+}
+
+#endif
@@ -1,45 +1,447 @@
 #ifndef _83c9a570_2b4b_481b_a810_85d3b5f3fe91
 #define _83c9a570_2b4b_481b_a810_85d3b5f3fe91
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
 #include "iterators.hpp"
 #include "optional.hpp"
 
 namespace fn{
 
-template<typename slice, typename T>
-class slice_IT
+namespace fn_ {
+
+/*
+ * Element loops behind fill, copy and compare of slices.
+ * Trivially copyable types are handed to memset/memmove/memcmp, whose
+ * library implementations pick the widest vector instructions of the
+ * cpu at runtime. Everything else gets a plain pointer loop, which the
+ * compiler can unroll and vectorize.
+ */
+
+template<typename T>
+using slice_trivial = std::is_trivially_copyable<typename std::remove_const<T>::type>;
+
+// memcmp equality is value equality only without padding, NaNs or -0.0
+template<typename T>
+using slice_bytewise_equal = std::integral_constant<bool,
+    std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value
+>;
+
+template<typename T>
+void slice_fill(T* d, size_t const n, T const& v, std::true_type)
+{
+    if(n){ std::memset(d, *reinterpret_cast<unsigned char const*>(&v), n); }
+}
+
+template<typename T>
+void slice_fill(T* d, size_t const n, T const& v, std::false_type)
+{
+    for(auto const e = d + n; d != e; ++d){
+        *d = v;
+    }
+}
+
+template<typename T>
+void slice_fill(T* const d, size_t const n, T const& v)
+{
+    slice_fill(d, n, v, std::integral_constant<bool,
+        sizeof(T) == 1 && slice_trivial<T>::value
+    >());
+}
+
+template<typename T>
+void slice_copy(T* const d, T const* const s, size_t const n, std::true_type)
+{
+    if(n){ std::memmove(d, s, n*sizeof(T)); }
+}
+
+template<typename T>
+void slice_copy(T* const d, T const* const s, size_t const n, std::false_type)
+{
+    for(size_t i = 0; i < n; ++i){
+        d[i] = s[i];
+    }
+}
+
+template<typename T>
+void slice_copy(T* const d, T const* const s, size_t const n)
+{
+    slice_copy(d, s, n, slice_trivial<T>());
+}
+
+template<typename T>
+bool slice_equal(T const* const a, T const* const b, size_t const n, std::true_type)
+{
+    return !n || std::memcmp(a, b, n*sizeof(T)) == 0;
+}
+
+template<typename T>
+bool slice_equal(T const* const a, T const* const b, size_t const n, std::false_type)
+{
+    for(size_t i = 0; i < n; ++i){
+        if(!(a[i] == b[i])){ return false; }
+    }
+    return true;
+}
+
+template<typename T>
+bool slice_equal(T const* const a, T const* const b, size_t const n)
+{
+    return slice_equal(a, b, n, slice_bytewise_equal<typename std::remove_const<T>::type>());
+}
+
+/*
+ * Search kernels. Byte sized integers are scanned 16 or 32 bytes at a
+ * time: find and substring search go to memchr and memmem, which the
+ * C library dispatches to the best vector unit; count and find_any use
+ * SSE2, or AVX2 where the cpu has it. Other types use plain loops.
+ */
+
+template<typename T>
+using slice_bytes = std::integral_constant<bool,
+    sizeof(T) == 1 && std::is_integral<typename std::remove_const<T>::type>::value
+>;
+
+static size_t const slice_none = size_t(-1);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+inline bool cpu_has_avx2()
+{
+    static bool const avx2 = []{
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+}
+
+__attribute__((target("avx2")))
+inline size_t count_bytes_avx2(uint8_t const* p, size_t n, uint8_t const v)
+{
+    size_t c = 0;
+    auto const needle = _mm256_set1_epi8(char(v));
+    for(; n >= 32; p += 32, n -= 32){
+        auto const block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+        c += __builtin_popcount(unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle))));
+    }
+    for(; n; ++p, --n){ c += *p == v; }
+    return c;
+}
+
+inline size_t count_bytes(uint8_t const* p, size_t n, uint8_t const v)
+{
+    if(n >= 64 && cpu_has_avx2()){ return count_bytes_avx2(p, n, v); }
+    size_t c = 0;
+    auto const needle = _mm_set1_epi8(char(v));
+    for(; n >= 16; p += 16, n -= 16){
+        auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+        c += __builtin_popcount(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))));
+    }
+    for(; n; ++p, --n){ c += *p == v; }
+    return c;
+}
+
+// only for small sets, every member costs a compare per block
+inline size_t find_any_bytes_sse2(uint8_t const* const p, size_t const n, uint8_t const* const set, size_t const k)
+{
+    __m128i needles[4];
+    for(size_t j = 0; j < k; ++j){ needles[j] = _mm_set1_epi8(char(set[j])); }
+
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+        auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+        auto hits = _mm_setzero_si128();
+        for(size_t j = 0; j < k; ++j){
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[j]));
+        }
+        auto const mask = unsigned(_mm_movemask_epi8(hits));
+        if(mask){ return i + size_t(__builtin_ctz(mask)); }
+    }
+    for(; i < n; ++i){
+        for(size_t j = 0; j < k; ++j){
+            if(p[i] == set[j]){ return i; }
+        }
+    }
+    return slice_none;
+}
+
+#else
+
+inline size_t count_bytes(uint8_t const* p, size_t n, uint8_t const v)
+{
+    size_t c = 0;
+    for(; n; ++p, --n){ c += *p == v; }
+    return c;
+}
+
+#endif
+
+inline size_t find_any_bytes(uint8_t const* const p, size_t const n, uint8_t const* const set, size_t const k)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if(k <= 4){ return find_any_bytes_sse2(p, n, set, k); }
+#endif
+    bool table[256] = {};
+    for(size_t j = 0; j < k; ++j){ table[set[j]] = true; }
+    for(size_t i = 0; i < n; ++i){
+        if(table[p[i]]){ return i; }
+    }
+    return slice_none;
+}
+
+template<typename T>
+uint8_t const* as_bytes(T const* const p) { return reinterpret_cast<uint8_t const*>(p); }
+
+template<typename T>
+size_t slice_find(T const* const p, size_t const n, T const& v, std::true_type)
+{
+    if(!n){ return slice_none; }
+    auto const r = std::memchr(p, int(uint8_t(v)), n);
+    return r ? size_t(static_cast<T const*>(r) - p) : slice_none;
+}
+
+template<typename T>
+size_t slice_find(T const* const p, size_t const n, T const& v, std::false_type)
+{
+    for(size_t i = 0; i < n; ++i){
+        if(p[i] == v){ return i; }
+    }
+    return slice_none;
+}
+
+template<typename T>
+size_t slice_count(T const* const p, size_t const n, T const& v, std::true_type)
+{
+    return count_bytes(as_bytes(p), n, uint8_t(v));
+}
+
+template<typename T>
+size_t slice_count(T const* const p, size_t const n, T const& v, std::false_type)
+{
+    size_t c = 0;
+    for(size_t i = 0; i < n; ++i){
+        c += p[i] == v;
+    }
+    return c;
+}
+
+template<typename T>
+size_t slice_find_any(T const* const p, size_t const n, T const* const set, size_t const k, std::true_type)
+{
+    return find_any_bytes(as_bytes(p), n, as_bytes(set), k);
+}
+
+template<typename T>
+size_t slice_find_any(T const* const p, size_t const n, T const* const set, size_t const k, std::false_type)
+{
+    for(size_t i = 0; i < n; ++i){
+        for(size_t j = 0; j < k; ++j){
+            if(p[i] == set[j]){ return i; }
+        }
+    }
+    return slice_none;
+}
+
+template<typename T>
+size_t slice_search(T const* const p, size_t const n, T const* const needle, size_t const k, std::true_type)
+{
+    if(!k){ return 0; }
+    if(k > n){ return slice_none; }
+    auto const r = memmem(p, n, needle, k);
+    return r ? size_t(static_cast<T const*>(r) - p) : slice_none;
+}
+
+template<typename T>
+size_t slice_search(T const* const p, size_t const n, T const* const needle, size_t const k, std::false_type)
+{
+    auto const r = std::search(p, p + n, needle, needle + k);
+    return (r == p + n && k) ? slice_none : size_t(r - p);
+}
+
+inline optional<size_t> slice_position(size_t const i)
 {
-    slice& s;
-    size_t position;
+    if(i == slice_none){ return {}; }
+    return i;
+}
+
+}
+
+template<typename T, size_t S=0> class slice;
+
+namespace fn_ {
+
+template<typename T>
+class StridedIT
+{
+    T* p;
+    ptrdiff_t step;
+
 public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename std::remove_const<T>::type;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    StridedIT(): p(nullptr), step(1) {}
+    StridedIT(T* const p, size_t const step): p(p), step(ptrdiff_t(step)) {}
+
+    T& operator*() const { return *p; }
+    T* operator->() const { return p; }
+    T& operator[](ptrdiff_t const n) const { return p[n*step]; }
+
+    StridedIT& operator++() { p += step; return *this; }
+    StridedIT& operator--() { p -= step; return *this; }
+    StridedIT operator++(int) { auto r = *this; p += step; return r; }
+    StridedIT operator--(int) { auto r = *this; p -= step; return r; }
+    StridedIT& operator+=(ptrdiff_t const n) { p += n*step; return *this; }
+    StridedIT& operator-=(ptrdiff_t const n) { p -= n*step; return *this; }
+    StridedIT operator+(ptrdiff_t const n) const { return StridedIT(*this) += n; }
+    StridedIT operator-(ptrdiff_t const n) const { return StridedIT(*this) -= n; }
+    ptrdiff_t operator-(StridedIT const& o) const { return (p - o.p) / step; }
+
+    bool operator==(StridedIT const& o) const { return p == o.p; }
+    bool operator!=(StridedIT const& o) const { return p != o.p; }
+    bool operator<(StridedIT const& o) const { return p < o.p; }
+    bool operator>(StridedIT const& o) const { return p > o.p; }
+    bool operator<=(StridedIT const& o) const { return p <= o.p; }
+    bool operator>=(StridedIT const& o) const { return p >= o.p; }
+};
+
+}
 
+/*
+ * View of every stride-th element of a contiguous array, such as
+ * a channel of interleaved samples or a column of a row-major matrix:
+ *
+ *  auto right = make_slice(samples).stride(2).subslice(1);
+ *  auto col = make_slice(matrix).column(3,width);
+ *
+ * The view does not own the elements and never reaches past the
+ * last element it covers.
+ */
+template<typename T>
+class strided_slice
+{
+public:
     using value_type = T;
+    using iterator = fn_::StridedIT<T>;
+    using const_iterator = fn_::StridedIT<T>;
+
+private:
+    T* _data;
+    size_t _size;
+    size_t _stride;
+
+    template<typename O_T>
+    friend class strided_slice;
+
+public:
+    strided_slice(): strided_slice(nullptr,0,1) {}
+
+    strided_slice(T* const _data, size_t const _size, size_t const _stride):
+        _data(_data),
+        _size(_size),
+        _stride(_stride ? _stride : 1)
+    {}
+
+    template<typename O_T>
+    strided_slice(strided_slice<O_T> const& o):
+        strided_slice(o._data,o._size,o._stride)
+    {}
 
-    slice_IT(slice& s, size_t position): s(s), position(position) {}
+    template<typename O_T, size_t O_S>
+    strided_slice(slice<O_T,O_S> const& o):
+        strided_slice(o.data(),o.size(),1)
+    {}
+
+    size_t size() const { return _size; }
+    size_t stride() const { return _stride; }
+    T* data() const { return _data; }
+
+    optional<T&> operator[](size_t const i) const
+    {
+        if(i<_size){
+            return _data[i*_stride];
+        }
+        else{
+            return {};
+        }
+    }
+
+    iterator begin() const { return iterator(_data,_stride); }
+    iterator end() const { return iterator(_data + _size*_stride,_stride); }
 
-    bool operator!=(slice_IT const& other) const
+    strided_slice subslice(size_t const o) const
     {
-        return position != other.position;
+        if(o >= _size){ return strided_slice(); }
+        return strided_slice(_data + o*_stride,_size - o,_stride);
     }
 
-    slice_IT const& operator++()
+    strided_slice first(size_t const s) const
     {
-        position += 1;
+        if(s > _size){ return strided_slice(); }
+        return strided_slice(_data,s,_stride);
+    }
+
+    /*
+     * Every n-th element of this view.
+     */
+    strided_slice stride(size_t const n) const
+    {
+        if(!n){ return strided_slice(); }
+        return strided_slice(_data,(_size + n - 1)/n,_stride*n);
+    }
+
+    strided_slice const& fill(T const& v) const
+    {
+        if(_stride == 1){
+            fn_::slice_fill(_data,_size,v);
+            return *this;
+        }
+        auto p = _data;
+        for(size_t i = 0; i < _size; ++i, p += _stride){
+            *p = v;
+        }
         return *this;
     }
 
-    T& operator*()
+    /*
+     * Copies the elements of source into this.
+     * Returns the part of source that was not copied.
+     */
+    strided_slice<T const> copy(strided_slice<T const> const source) const
     {
-        return s._data[position];
+        auto const n = std::min(_size, source._size);
+        if(_stride == 1 && source._stride == 1){
+            fn_::slice_copy(_data,source._data,n);
+        }
+        else{
+            auto d = _data;
+            auto s = source._data;
+            for(size_t i = 0; i < n; ++i, d += _stride, s += source._stride){
+                *d = *s;
+            }
+        }
+        return source.subslice(n);
     }
 };
 
-template<typename T, size_t S=0>
+template<typename T, size_t S>
 class slice
 {
 public:
     using value_type = T;
+    // slices are views: a const slice still grants access to the elements
+    using iterator = T*;
+    using const_iterator = T*;
 
 private:
     T* _data;
@@ -47,8 +449,6 @@ private:
     template<typename O_T, size_t O_S>
     friend class slice;
 
-    friend class slice_IT<slice,T>;
-    friend class slice_IT<slice const,T>;
 
     explicit slice(T* const d,int):
         _data(d)
@@ -116,6 +516,8 @@ public:
         return S;
     }
 
+    T* data() const { return _data; }
+
     optional<T&> operator[](size_t const i) const
     {
         if(i<S){
@@ -126,29 +528,38 @@ public:
         }
     }
 
-    slice_IT<slice const,T> begin() const
+    T* begin() const { return _data; }
+    T* end() const { return _data + size(); }
+
+    slice const& fill(T const& v) const
     {
-        return {*this,0};
+        fn_::slice_fill(_data, S, v);
+        return *this;
     }
 
-    slice_IT<slice const,T> end() const
+    void copy(slice const& o) const
     {
-        return {*this,size()};
+        fn_::slice_copy(_data, o._data, S);
     }
 
-    slice const& fill(T const& v) const
+    bool compare(slice const& o) const
     {
-        for(auto& x: *this){
-            x = v;
-        }
-        return *this;
+        return fn_::slice_equal(_data, o._data, S);
     }
 
-    void copy(slice const& o) const
+    optional<size_t> find(T const& v) const { return slice<T>(*this).find(v); }
+    optional<size_t> find(slice<T const> const n) const { return slice<T>(*this).find(n); }
+    optional<size_t> find_any(slice<T const> const set) const { return slice<T>(*this).find_any(set); }
+    size_t count(T const& v) const { return slice<T>(*this).count(v); }
+
+    strided_slice<T> stride(size_t const n) const
     {
-        for(auto&& i: range(S)){
-            _data[i] = o._data[i];
-        }
+        return slice<T>(*this).stride(n);
+    }
+
+    strided_slice<T> column(size_t const k, size_t const width) const
+    {
+        return slice<T>(*this).column(k,width);
     }
 
     template<typename RT, size_t C=0>
@@ -175,12 +586,12 @@ class slice<T,0>
 {
 public:
     using value_type = T;
+    using iterator = T*;
+    using const_iterator = T*;
 
 private:
     size_t _size;
     T* _data;
-    friend class slice_IT<slice,T>;
-    friend class slice_IT<slice const,T>;
     friend class slice<T const,0>;
 
 public:
@@ -241,21 +652,12 @@ public:
     size_t size() const { return _size; }
     T* data() const { return _data; }
 
-    slice_IT<slice const,T> begin() const
-    {
-        return {*this,0};
-    }
-
-    slice_IT<slice const,T> end() const
-    {
-        return {*this,size()};
-    }
+    T* begin() const { return _data; }
+    T* end() const { return _data + size(); }
 
     slice const& fill(T const& v) const
     {
-        for(auto&& x: *this){
-            x = v;
-        }
+        fn_::slice_fill(_data, _size, v);
         return *this;
     }
 
@@ -265,14 +667,8 @@ public:
      */
     slice<T const> copy(slice<T const> const source) const
     {
-        size_t n = 0;
-        auto s = source.begin();
-        for(auto&& d: *this){
-            if(!(s != source.end())){ break; }
-            d = *s;
-            ++s;
-            ++n;
-        }
+        auto const n = std::min(size(), source.size());
+        fn_::slice_copy(_data, source.data(), n);
         return source.subslice(n);
     }
 
@@ -283,15 +679,40 @@ public:
 
     bool compare(slice const o) const
     {
-        if(size() != o.size()){
-            return false;
-        }
-        for(auto&& v: zip(*this,o)){
-            if(!(v.first == v.second)){
-                return false;
-            }
-        }
-        return true;
+        return size() == o.size() && fn_::slice_equal(_data, o._data, _size);
+    }
+
+    /*
+     * Position of the first element equal to v.
+     */
+    optional<size_t> find(T const& v) const
+    {
+        return fn_::slice_position(fn_::slice_find<T>(_data, _size, v, fn_::slice_bytes<T>()));
+    }
+
+    /*
+     * Position of the first occurrence of needle.
+     */
+    optional<size_t> find(slice<T const> const needle) const
+    {
+        return fn_::slice_position(fn_::slice_search<T>(
+            _data, _size, needle.data(), needle.size(), fn_::slice_bytes<T>()
+        ));
+    }
+
+    /*
+     * Position of the first element that is equal to any element of set.
+     */
+    optional<size_t> find_any(slice<T const> const set) const
+    {
+        return fn_::slice_position(fn_::slice_find_any<T>(
+            _data, _size, set.data(), set.size(), fn_::slice_bytes<T>()
+        ));
+    }
+
+    size_t count(T const& v) const
+    {
+        return fn_::slice_count<T>(_data, _size, v, fn_::slice_bytes<T>());
     }
 
     auto subslice(size_t o) const -> slice<T,0>
@@ -326,6 +747,23 @@ public:
         }
     }
 
+    /*
+     * Every n-th element, starting with the first one.
+     */
+    strided_slice<T> stride(size_t const n) const
+    {
+        return strided_slice<T>(_data,_size,1).stride(n);
+    }
+
+    /*
+     * Column k, if this is a row-major matrix with rows of width elements.
+     */
+    strided_slice<T> column(size_t const k, size_t const width) const
+    {
+        if(k >= width || k >= _size){ return strided_slice<T>(); }
+        return strided_slice<T>(_data + k,(_size - k + width - 1)/width,width);
+    }
+
     template<typename RT>
     auto reinterpret_as(size_t const c=0) const -> slice<RT>
     {
@@ -0,0 +1,203 @@
+#ifndef _0d8e4b6a_7c21_4f9e_b3a5_58e1c6f92d07
+#define _0d8e4b6a_7c21_4f9e_b3a5_58e1c6f92d07
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include "slice.hpp"
+
+namespace fn {
+
+namespace fn_ {
+
+/*
+ * Edge length of square tiles that fit into 16KB, half of a typical L1
+ * data cache, so that a source and a destination tile fit together.
+ */
+template<typename T>
+constexpr size_t tile_edge(size_t const edge=256)
+{
+    return (edge > 1 && edge*edge*sizeof(T) > 16*1024) ? tile_edge<T>(edge/2) : edge;
+}
+
+}
+
+/*
+ * Non-owning view of a Rank dimensional array, laid out row-major in
+ * a slice. Sub-views keep the strides of the array they were taken from,
+ * so the last dimension is always contiguous:
+ *
+ *  slice_nd<float,2> image(make_slice(pixels),{height,width});
+ *  auto roi = image.subslice({y,x},{h,w});
+ *  roi.rows([](slice<float> row){ ... });
+ *  roi(0,1) >>[](float& p){ ... };
+ *
+ * Positions outside of the view yield empty optionals, sub-views are
+ * clipped to the view.
+ */
+template<typename T, size_t Rank>
+class slice_nd
+{
+    static_assert(Rank > 0, "fn::slice_nd: rank must be at least 1");
+
+public:
+    using value_type = T;
+    using index = std::array<size_t,Rank>;
+
+private:
+    T* _data;
+    index _shape;
+    index _strides;
+
+    slice_nd(T* const data, index const& shape, index const& strides):
+        _data(data),
+        _shape(shape),
+        _strides(strides)
+    {}
+
+    static size_t count(index const& shape)
+    {
+        size_t n = 1;
+        for(auto const s: shape){ n *= s; }
+        return n;
+    }
+
+    template<size_t D, typename F>
+    void rows(T* const p, F& f, std::integral_constant<size_t,D>) const
+    {
+        for(size_t i = 0; i < _shape[D]; ++i){
+            rows(p + i*_strides[D], f, std::integral_constant<size_t,D+1>());
+        }
+    }
+
+    template<typename F>
+    void rows(T* const p, F& f, std::integral_constant<size_t,Rank-1>) const
+    {
+        f(slice<T>(p,_shape[Rank-1]));
+    }
+
+public:
+    slice_nd(): _data(nullptr), _shape(), _strides() {}
+
+    /*
+     * Views the start of s as an array of the given shape.
+     * The view is empty if s is too small.
+     */
+    slice_nd(slice<T> const s, index const& shape):
+        _data(s.data()),
+        _shape(shape),
+        _strides()
+    {
+        if(count(shape) > s.size()){
+            _shape = index();
+        }
+        size_t stride = 1;
+        for(size_t d = Rank; d > 0; --d){
+            _strides[d-1] = stride;
+            stride *= _shape[d-1];
+        }
+    }
+
+    index const& shape() const { return _shape; }
+    size_t size(size_t const dimension) const { return _shape[dimension]; }
+    size_t stride(size_t const dimension) const { return _strides[dimension]; }
+    size_t count() const { return count(_shape); }
+    T* data() const { return _data; }
+
+    optional<T&> operator[](index const& i) const
+    {
+        size_t offset = 0;
+        for(size_t d = 0; d < Rank; ++d){
+            if(i[d] >= _shape[d]){ return {}; }
+            offset += i[d]*_strides[d];
+        }
+        return _data[offset];
+    }
+
+    template<typename ...I>
+    optional<T&> operator()(I const... i) const
+    {
+        static_assert(sizeof...(I) == Rank, "fn::slice_nd: wrong number of indices");
+        return (*this)[index{{size_t(i)...}}];
+    }
+
+    /*
+     * The part of the view of the given extent, starting at from.
+     */
+    slice_nd subslice(index const& from, index const& extent) const
+    {
+        index shape;
+        size_t offset = 0;
+        for(size_t d = 0; d < Rank; ++d){
+            if(from[d] >= _shape[d]){ return slice_nd(); }
+            shape[d] = std::min(extent[d], _shape[d] - from[d]);
+            offset += from[d]*_strides[d];
+        }
+        return slice_nd(_data + offset, shape, _strides);
+    }
+
+    /*
+     * Calls f with each contiguous row of the last dimension, in order.
+     */
+    template<typename F>
+    void rows(F f) const
+    {
+        if(!count()){ return; }
+        rows(_data, f, std::integral_constant<size_t,0>());
+    }
+
+    /*
+     * Row i of a two dimensional view.
+     */
+    slice<T> row(size_t const i) const
+    {
+        static_assert(Rank == 2, "fn::slice_nd: row needs a two dimensional view");
+        if(i >= _shape[0]){ return slice<T>(); }
+        return slice<T>(_data + i*_strides[0], _shape[1]);
+    }
+
+    /*
+     * Column j of a two dimensional view.
+     */
+    strided_slice<T> column(size_t const j) const
+    {
+        static_assert(Rank == 2, "fn::slice_nd: column needs a two dimensional view");
+        if(j >= _shape[1]){ return strided_slice<T>(); }
+        return strided_slice<T>(_data + j, _shape[0], _strides[0]);
+    }
+
+    /*
+     * Calls f with sub-views of at most height x width elements and
+     * their position, covering a two dimensional view row of tiles by
+     * row of tiles.
+     * Working tile by tile keeps accesses with large strides, as in
+     * transposes and stencils, within the cache.
+     */
+    template<typename F>
+    void tiles(size_t const height, size_t const width, F f) const
+    {
+        static_assert(Rank == 2, "fn::slice_nd: tiles needs a two dimensional view");
+        if(!height || !width){ return; }
+        for(size_t y = 0; y < _shape[0]; y += height){
+            for(size_t x = 0; x < _shape[1]; x += width){
+                f(subslice({{y,x}},{{height,width}}), index{{y,x}});
+            }
+        }
+    }
+
+    /*
+     * Square tiles sized for the L1 cache.
+     */
+    template<typename F>
+    void tiles(F f) const
+    {
+        tiles(fn_::tile_edge<T>(), fn_::tile_edge<T>(), f);
+    }
+};
+
+template<typename T>
+using slice2d = slice_nd<T,2>;
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef _5c0e8f3b_93a1_4c2e_b7d4_2e61a0f4c9d8
+#define _5c0e8f3b_93a1_4c2e_b7d4_2e61a0f4c9d8
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "optional.hpp"
+
+namespace fn {
+
+/*
+ * 32 bit reference to a value in a slot_map: the low IndexBits select
+ * the slot, the remaining bits hold the generation of the slot at the
+ * time the value was inserted. The default handle refers to nothing.
+ */
+template<unsigned IndexBits>
+struct slot_handle
+{
+    static_assert(IndexBits > 0 && IndexBits < 32, "slot_handle: IndexBits must be in 1..31");
+
+    static uint32_t const index_mask = (uint32_t(1) << IndexBits) - 1;
+
+    uint32_t bits;
+
+    slot_handle(): bits(0) {}
+    explicit slot_handle(uint32_t const bits): bits(bits) {}
+    slot_handle(uint32_t const index, uint32_t const generation):
+        bits((generation << IndexBits) | index)
+    {}
+
+    uint32_t index() const { return bits & index_mask; }
+    uint32_t generation() const { return bits >> IndexBits; }
+
+    bool operator==(slot_handle const& o) const { return bits == o.bits; }
+    bool operator!=(slot_handle const& o) const { return bits != o.bits; }
+};
+
+/*
+ * Dense storage for objects that are referred to by many others.
+ * Instead of a ref (three pointers) each reference is a 32 bit handle,
+ * resolved through a slot table that checks the generation:
+ *
+ *  slot_map<Entity> entities;
+ *  auto h = entities.insert(Entity());
+ *  entities.get(h) >>[](Entity& e){ ... };
+ *  entities.erase(h);
+ *  entities.get(h);   // empty, the handle is stale
+ *
+ * Values are kept contiguous: erase moves the last value into the gap,
+ * so iteration covers live values only, in no particular order, and
+ * pointers to values are invalidated by insert and erase.
+ *
+ * A slot whose generation is exhausted is retired instead of reused,
+ * so a stale handle never resolves to a newer value.
+ */
+template<typename T, unsigned IndexBits=24>
+class slot_map
+{
+public:
+    typedef slot_handle<IndexBits> handle;
+
+private:
+    static uint32_t const max_slots = handle::index_mask + 1;
+    static uint32_t const max_generation = (uint32_t(1) << (32 - IndexBits)) - 1;
+    static uint32_t const none = uint32_t(-1);
+
+    struct Slot
+    {
+        // position in values while in use, next free slot otherwise
+        uint32_t position;
+        // generations start at 1, so that the default handle is never valid
+        uint32_t generation;
+    };
+
+    std::vector<T> values;
+    // slot of each value
+    std::vector<uint32_t> owners;
+    std::vector<Slot> slots;
+    uint32_t free_slots = none;
+
+    Slot const* find(handle const h) const
+    {
+        if(h.index() >= slots.size() || h.generation() == 0){ return nullptr; }
+        auto const& s = slots[h.index()];
+        if(s.generation != h.generation()){ return nullptr; }
+        return &s;
+    }
+
+    uint32_t acquire_slot()
+    {
+        if(free_slots != none){
+            auto const i = free_slots;
+            free_slots = slots[i].position;
+            return i;
+        }
+        if(slots.size() >= max_slots){
+            throw std::length_error("fn::slot_map: out of slots");
+        }
+        slots.push_back(Slot{0,1});
+        return uint32_t(slots.size() - 1);
+    }
+
+    // invalidates all handles to slot i and makes it available again
+    void release_slot(uint32_t const i)
+    {
+        auto& s = slots[i];
+        if(s.generation < max_generation){
+            ++s.generation;
+            s.position = free_slots;
+            free_slots = i;
+        }
+        else{
+            // retired: never handed out again
+            s.generation = 0;
+        }
+    }
+
+public:
+    slot_map() {}
+
+    template<typename ...Args>
+    handle emplace(Args&&... args)
+    {
+        auto const i = acquire_slot();
+        auto const position = uint32_t(values.size());
+        values.emplace_back(std::forward<Args>(args)...);
+        owners.push_back(i);
+        slots[i].position = position;
+        return handle(i, slots[i].generation);
+    }
+
+    handle insert(T const& v) { return emplace(v); }
+    handle insert(T&& v) { return emplace(std::move(v)); }
+
+    optional<T&> get(handle const h)
+    {
+        auto const s = find(h);
+        if(s){ return values[s->position]; }
+        return {};
+    }
+
+    optional<T const&> get(handle const h) const
+    {
+        auto const s = find(h);
+        if(s){ return values[s->position]; }
+        return {};
+    }
+
+    bool contains(handle const h) const { return find(h) != nullptr; }
+
+    /*
+     * Removes the value of h, if it is still there.
+     * All handles to it become stale.
+     */
+    bool erase(handle const h)
+    {
+        if(!find(h)){ return false; }
+
+        auto& s = slots[h.index()];
+        auto const last = uint32_t(values.size() - 1);
+        if(s.position != last){
+            values[s.position] = std::move(values[last]);
+            owners[s.position] = owners[last];
+            slots[owners[last]].position = s.position;
+        }
+        values.pop_back();
+        owners.pop_back();
+
+        release_slot(h.index());
+        return true;
+    }
+
+    /*
+     * Handle of the value at position i of the iteration order.
+     */
+    handle handle_at(size_t const i) const
+    {
+        return handle(owners[i], slots[owners[i]].generation);
+    }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    void reserve(size_t const n)
+    {
+        values.reserve(n);
+        owners.reserve(n);
+        slots.reserve(n);
+    }
+
+    void clear()
+    {
+        for(auto const i: owners){ release_slot(i); }
+        values.clear();
+        owners.clear();
+    }
+
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values.end(); }
+};
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef _33128b50_cfb2_4f58_aa60_82c8585f832e
 #define _33128b50_cfb2_4f58_aa60_82c8585f832e
 
+#include <cstddef>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 #include "common.hpp"
 #include "optional.hpp"
 
@@ -14,14 +18,69 @@ void lock(Mutex& m) { m.lock(); }
 template<typename Mutex>
 void unlock(Mutex& m) { m.unlock(); }
 
+template<typename Mutex>
+bool try_lock(Mutex& m) { return m.try_lock(); }
+
+namespace fn_ {
+
+struct prefer_member {};
+struct use_fallback { use_fallback(prefer_member) {} };
+
+template<typename Mutex, typename Duration>
+auto try_lock_for(Mutex& m, Duration const& timeout, prefer_member)
+    -> decltype(m.try_lock_for(timeout))
+{
+    return m.try_lock_for(timeout);
+}
+
+template<typename Mutex, typename Duration>
+bool try_lock_for(Mutex& m, Duration const& timeout, use_fallback)
+{
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while(!fn::try_lock(m)){
+        if(std::chrono::steady_clock::now() >= deadline){ return false; }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+template<typename ...S> struct SyncList;
+template<typename S, typename P> class WaitUntil;
+
+}
+
+/*
+ * Uses m.try_lock_for if the mutex has it,
+ * otherwise polls try_lock until the timeout expires.
+ */
+template<typename Mutex, typename Rep, typename Period>
+bool try_lock_for(Mutex& m, std::chrono::duration<Rep,Period> const& timeout)
+{
+    return fn_::try_lock_for(m, timeout, fn_::prefer_member());
+}
+
 template<typename T, typename Mutex> class guard;
 
-/* template<typename T1, typename T2, typename Mutex> */
-/* auto guard_cast(guard<T1&,Mutex> o, optional<T2> v) */
-/*     ->guard<T2,Mutex> */
-/* { */
-/*     return guard<T2,Mutex>(fn_::move(o.mutex),fn_::move(v)); */
-/* } */
+/*
+ * Tags to construct a guard for a mutex that is already locked,
+ * or one that gives up if the mutex is busy.
+ */
+struct adopt_lock_t {};
+static auto const adopt_lock = adopt_lock_t();
+
+struct try_to_lock_t {};
+static auto const try_to_lock = try_to_lock_t();
+
+/*
+ * A functor that returns a value does not need the lock anymore,
+ * so the guard is released and the value returned as an optional.
+ */
+template<typename T1, typename T2, typename Mutex>
+auto guard_cast(guard<T1&,Mutex>, optional<T2> v)
+    ->optional<T2>
+{
+    return v;
+}
 
 template<typename T1, typename T2, typename Mutex>
 auto guard_cast(guard<T1&,Mutex> o, optional<T2&> v)
@@ -50,6 +109,32 @@ public:
         mutex >> lock<Mutex>;
     }
 
+    guard(Mutex& mutex_, T& value_, adopt_lock_t):
+        mutex(mutex_),
+        value(value_)
+    {}
+
+    /*
+     * If the mutex can not be locked (in time), the guard is empty
+     * and functors applied to it are not called.
+     */
+    guard(Mutex& mutex_, T& value_, try_to_lock_t)
+    {
+        if(fn::try_lock(mutex_)){
+            mutex = mutex_;
+            value = value_;
+        }
+    }
+
+    template<typename Rep, typename Period>
+    guard(Mutex& mutex_, T& value_, std::chrono::duration<Rep,Period> const& timeout)
+    {
+        if(fn::try_lock_for(mutex_,timeout)){
+            mutex = mutex_;
+            value = value_;
+        }
+    }
+
     guard(guard const&) = delete;
 
     guard(guard&& o)
@@ -64,10 +149,6 @@ public:
     friend auto guard_cast(guard<T1&,M> o, optional<T2&> v)
         ->guard<T2&,M>;
 
-    /* template<typename T1, typename T2, typename M> */
-    /* friend auto guard_cast(guard<T1&,M> o, optional<T2> v) */
-    /*     ->guard<T2,M>; */
-
     template<typename T1, typename M>
     friend auto guard_cast(guard<T1&,M> o, optional<void> v)
         ->guard<void,M>;
@@ -95,6 +176,13 @@ public:
         return r;
     }
 
+    template<typename EmptyF>
+    auto operator||(EmptyF const& handle_no_value) const
+        -> decltype(value || handle_no_value)
+    {
+        return value || handle_no_value;
+    }
+
     ~guard() { mutex >> unlock<Mutex>; }
 };
 
@@ -104,13 +192,21 @@ template<typename Mutex>
 class guard<void,Mutex>
 {
     optional<Mutex&> mutex;
+    optional<void> done;
 public:
-    guard(optional<Mutex&>&& m, optional<void>&&)
+    guard(optional<Mutex&>&& m, optional<void>&& d):
+        done(d)
     {
         mutex = fn_::move(m);
         m = {};
     }
 
+    template<typename EmptyF>
+    void operator||(EmptyF const& handle_no_value) const
+    {
+        done || handle_no_value;
+    }
+
     ~guard() { mutex >> unlock<Mutex>; }
 };
 
@@ -132,21 +228,168 @@ public:
     T* operator->() { return &value; }
 };
 
-template<typename T, typename Mutex=std::mutex>
-class synchronized final
+namespace fn_ {
+
+/*
+ * Type erased handle to a mutex, so that a set of mutexes of
+ * different types can be locked by one (non template) algorithm.
+ */
+struct Lockable
+{
+    void* mutex;
+    void (*lock)(void*);
+    bool (*try_lock)(void*);
+    void (*unlock)(void*);
+
+    template<typename Mutex>
+    struct Ops
+    {
+        static void lock(void* m) { fn::lock(*static_cast<Mutex*>(m)); }
+        static bool try_lock(void* m) { return fn::try_lock(*static_cast<Mutex*>(m)); }
+        static void unlock(void* m) { fn::unlock(*static_cast<Mutex*>(m)); }
+    };
+
+    template<typename Mutex>
+    static Lockable of(Mutex& m)
+    {
+        return Lockable{&m, &Ops<Mutex>::lock, &Ops<Mutex>::try_lock, &Ops<Mutex>::unlock};
+    }
+};
+
+/*
+ * A thread blocked in synchronized::wait_until.
+ */
+template<typename T>
+struct Waiter
 {
+    Waiter* next;
+    void const* predicate;
+    bool (*check)(void const*, T const&);
+    std::condition_variable_any cv;
+    bool woken;
+};
+
+/*
+ * The lock of a synchronized object. Unlocking it evaluates the
+ * predicates of all waiting threads and wakes those whose
+ * predicate holds, so that waiters are not woken by every change.
+ */
+template<typename T, typename Mutex>
+class Monitor
+{
+protected:
     Mutex mutable mutex;
+    Waiter<T>* waiters = nullptr;
     T value;
+
+    template<typename ...Args>
+    Monitor(Args... args): value(args...) {}
+
+    template<typename P>
+    static bool check(void const* p, T const& v)
+    {
+        return (*static_cast<P const*>(p))(v);
+    }
+
+    // requires the mutex to be locked
+    template<typename P>
+    void wait_locked(P const& p)
+    {
+        while(!p(static_cast<T const&>(value))){
+            Waiter<T> w;
+            w.next = waiters;
+            w.predicate = &p;
+            w.check = &check<P>;
+            w.woken = false;
+            waiters = &w;
+            while(!w.woken){
+                w.cv.wait(mutex);
+            }
+        }
+    }
+
+public:
+    void lock() { fn::lock(mutex); }
+
+    bool try_lock() { return fn::try_lock(mutex); }
+
+    template<typename Duration>
+    bool try_lock_for(Duration const& timeout) { return fn::try_lock_for(mutex,timeout); }
+
+    void unlock()
+    {
+        auto w = &waiters;
+        while(*w){
+            auto const waiter = *w;
+            if(waiter->check(waiter->predicate, value)){
+                *w = waiter->next;
+                waiter->woken = true;
+                waiter->cv.notify_one();
+            }
+            else{
+                w = &waiter->next;
+            }
+        }
+        fn::unlock(mutex);
+    }
+};
+
+template<typename S, typename P>
+class WaitUntil
+{
+    S& s;
+    P const p;
+
+public:
+    WaitUntil(S& s, P const& p): s(s), p(p) {}
+
+    template<typename F>
+    auto operator>>(F const& f) -> decltype(s.when(p,f))
+    {
+        return s.when(p,f);
+    }
+};
+
+}
+
+template<typename T, typename Mutex=std::mutex>
+class synchronized final : private fn_::Monitor<T,Mutex>
+{
+    typedef fn_::Monitor<T,Mutex> Monitor;
+    using Monitor::mutex;
+    using Monitor::value;
+
+    template<typename ...S>
+    friend struct fn_::SyncList;
+
+    template<typename S, typename P>
+    friend class fn_::WaitUntil;
+
+    Monitor& monitor() { return *this; }
+
+    fn_::Lockable lockable() { return fn_::Lockable::of(monitor()); }
+    fn_::Lockable lockable() const { return fn_::Lockable::of(mutex); }
+
+    template<typename P, typename F>
+    auto when(P const& p, F const& f)
+        -> decltype(fn::guard<T&,Monitor>(monitor(),value) >> f)
+    {
+        monitor().lock();
+        fn::guard<T&,Monitor> g(monitor(),value,adopt_lock);
+        this->wait_locked(p);
+        return g >> f;
+    }
+
 public:
     using Type = T;
 
     template<typename ...Args>
-    synchronized(Args... args): value(args...) {}
+    synchronized(Args... args): Monitor(args...) {}
 
     template<typename F>
-    auto operator>>(F const& f) -> decltype(fn::guard<T&,Mutex>(mutex,value) >> f)
+    auto operator>>(F const& f) -> decltype(fn::guard<T&,Monitor>(monitor(),value) >> f)
     {
-        return fn::guard<T&,Mutex>(mutex,value) >> f;
+        return fn::guard<T&,Monitor>(monitor(),value) >> f;
     }
 
     template<typename F>
@@ -155,11 +398,73 @@ public:
         return fn::guard<T const&,Mutex>(mutex,value) >> f;
     }
 
+    /*
+     * Like operator>>, but gives up instead of blocking if the lock
+     * is busy. The result is empty in that case:
+     *
+     *  queue.try_apply([](Queue& q){ q.push(item); })
+     *  ||[&]{ deferred.push_back(item); };
+     */
+    template<typename F>
+    auto try_apply(F const& f) -> decltype(fn::guard<T&,Monitor>(monitor(),value) >> f)
+    {
+        return fn::guard<T&,Monitor>(monitor(),value,try_to_lock) >> f;
+    }
+
+    template<typename F>
+    auto try_apply(F const& f) const -> decltype(fn::guard<T const&,Mutex>(mutex,value) >> f)
+    {
+        return fn::guard<T const&,Mutex>(mutex,value,try_to_lock) >> f;
+    }
+
+    /*
+     * Like try_apply, but waits up to timeout for the lock.
+     */
+    template<typename Rep, typename Period, typename F>
+    auto apply_for(std::chrono::duration<Rep,Period> const& timeout, F const& f)
+        -> decltype(fn::guard<T&,Monitor>(monitor(),value) >> f)
+    {
+        return fn::guard<T&,Monitor>(monitor(),value,timeout) >> f;
+    }
+
+    template<typename Rep, typename Period, typename F>
+    auto apply_for(std::chrono::duration<Rep,Period> const& timeout, F const& f) const
+        -> decltype(fn::guard<T const&,Mutex>(mutex,value) >> f)
+    {
+        return fn::guard<T const&,Mutex>(mutex,value,timeout) >> f;
+    }
+
+    /*
+     * Blocks until p(value) holds, then applies f like operator>>:
+     *
+     *  state.wait_until([](State const& s){ return s.ready; })
+     *  >>[](State& s){ ... };
+     *
+     * p is evaluated with the lock held, also by threads that modify
+     * the value, and must not throw.
+     */
+    template<typename P>
+    auto wait_until(P const& p) -> fn_::WaitUntil<synchronized,P>
+    {
+        return fn_::WaitUntil<synchronized,P>(*this,p);
+    }
+
+    /*
+     * Wakes the waiters whose predicate holds.
+     * Only needed if a predicate depends on more than the value,
+     * changes made through this object notify automatically.
+     */
+    void notify()
+    {
+        monitor().lock();
+        monitor().unlock();
+    }
+
     T take()
     {
-        mutex.lock();
+        monitor().lock();
         auto t = T(fn_::move(value));
-        mutex.unlock();
+        monitor().unlock();
         return fn_::move(t);
     }
 
@@ -172,9 +477,18 @@ public:
     }
 
 
-    fn::synchronized_guard<T,Mutex> guard()
+    /*
+     * The mutex itself, e.g. to configure it.
+     * Locking it directly bypasses the guard machinery.
+     */
+    Mutex& get_mutex() const
     {
-        return fn::synchronized_guard<T,Mutex>(mutex,value);
+        return mutex;
+    }
+
+    fn::synchronized_guard<T,Monitor> guard()
+    {
+        return fn::synchronized_guard<T,Monitor>(monitor(),value);
     }
 
     fn::synchronized_guard<T const,Mutex> guard() const
@@ -183,17 +497,124 @@ public:
     }
 };
 
-/* #define FN_FAIL A_functor_applied_to_a_guard_must_return_either_a_reference_or_void */
+namespace fn_ {
 
-/* struct FN_FAIL { FN_FAIL() = delete; }; */
+/*
+ * Locks all mutexes without risking a deadlock, using the same back-off
+ * strategy as std::lock: block on one mutex, try the others and if one
+ * of them is busy, release everything and start over by blocking on the
+ * one that was busy.
+ */
+inline void lock_all(Lockable* const locks, size_t const n)
+{
+    size_t first = 0;
+    for(;;){
+        locks[first].lock(locks[first].mutex);
+
+        size_t i = 1;
+        for(; i < n; ++i){
+            auto& l = locks[(first + i) % n];
+            if(!l.try_lock(l.mutex)){ break; }
+        }
+        if(i == n){ return; }
+
+        auto const busy = (first + i) % n;
+        while(i > 0){
+            --i;
+            auto& l = locks[(first + i) % n];
+            l.unlock(l.mutex);
+        }
+        first = busy;
+    }
+}
+
+template<size_t N>
+struct LockSet
+{
+    Lockable locks[N];
+
+    ~LockSet()
+    {
+        for(size_t i = N; i > 0; --i){
+            locks[i-1].unlock(locks[i-1].mutex);
+        }
+    }
+};
+
+template<>
+struct SyncList<>
+{
+    void collect(Lockable*) const {}
+
+    template<typename F, typename ...V>
+    auto apply(F const& f, V&... v) const -> decltype(f(v...))
+    {
+        return f(v...);
+    }
+};
+
+template<typename H, typename ...S>
+struct SyncList<H,S...>
+{
+    H& head;
+    SyncList<S...> tail;
+
+    SyncList(H& head, S&... s): head(head), tail(s...) {}
+
+    void collect(Lockable* const l) const
+    {
+        *l = head.lockable();
+        tail.collect(l+1);
+    }
+
+    template<typename F, typename ...V>
+    auto apply(F const& f, V&... v) const
+        -> decltype(tail.apply(f, v..., head.value))
+    {
+        return tail.apply(f, v..., head.value);
+    }
+};
 
-/* template<typename T, typename Mutex, typename F> */
-/* FN_FAIL operator>>(synchronized<T,Mutex>,F) */
-/* { */
-/*     return {}; */
-/* } */
+template<typename ...S>
+class Synchronize
+{
+    SyncList<S...> list;
+
+public:
+    Synchronize(S&... s): list(s...) {}
+
+    /*
+     * Calls f with references to all values while holding all locks.
+     * The result is returned by value, so that no reference to the
+     * guarded data can escape the locked region.
+     */
+    template<typename F>
+    auto operator>>(F const& f)
+        -> typename remove_reference<decltype(list.apply(f))>::T
+    {
+        LockSet<sizeof...(S)> set;
+        list.collect(set.locks);
+        lock_all(set.locks, sizeof...(S));
+        return list.apply(f);
+    }
+};
+
+}
+
+/*
+ * Locks several synchronized objects at once, avoiding deadlocks
+ * regardless of the order in which different threads name them:
+ *
+ *  synchronize(a,b) >>[](Account& a, Account& b){ ... };
+ *
+ * Passing the same object twice is not allowed.
+ */
+template<typename ...S>
+auto synchronize(S&... s) -> fn_::Synchronize<S...>
+{
+    return fn_::Synchronize<S...>(s...);
+}
 
-/* #undef FN_FAIL */
 
 };
 
@@ -0,0 +1,99 @@
+#ifndef _f456d5e2_a765_49f5_84a4_f86ac5e51fea
+#define _f456d5e2_a765_49f5_84a4_f86ac5e51fea
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace fn {
+
+/*
+ * A value that is updated optimistically instead of under a lock:
+ * update(f) copies the current version, lets f modify the copy and
+ * publishes the result only if no other update was committed in the
+ * meantime, otherwise it starts over with the newer version.
+ *
+ *  cell.update([](Limits& l){ l.used += n; });
+ *
+ * f may therefore run more than once and should have no side effects
+ * besides modifying its argument. Versions are immutable and reached
+ * through a pointer, so readers never see a partial update and never
+ * block writers.
+ */
+template<typename T>
+class versioned_cell
+{
+    struct Version
+    {
+        T value;
+        uint64_t number;
+    };
+
+    typedef std::shared_ptr<Version const> Ptr;
+
+    Ptr current;
+    std::atomic<uint64_t> _commits{0};
+    std::atomic<uint64_t> _retries{0};
+
+    Ptr load() const { return std::atomic_load(&current); }
+
+public:
+    template<typename ...Args>
+    versioned_cell(Args... args):
+        current(new Version{T(args...),0})
+    {}
+
+    versioned_cell(versioned_cell const&) = delete;
+
+    /*
+     * Calls f with a consistent snapshot of the value.
+     */
+    template<typename F>
+    auto read(F const& f) const -> decltype(f(std::declval<T const&>()))
+    {
+        auto const v = load();
+        return f(v->value);
+    }
+
+    T get() const { return load()->value; }
+
+    /*
+     * Number of committed updates.
+     */
+    uint64_t version() const { return load()->number; }
+
+    /*
+     * Applies f to a copy of the current value and commits it.
+     * Returns how often f had to be retried because of concurrent updates.
+     */
+    template<typename F>
+    uint64_t update(F const& f)
+    {
+        uint64_t retries = 0;
+        auto expected = load();
+        for(;;){
+            auto const next = std::make_shared<Version>(
+                Version{expected->value, expected->number + 1}
+            );
+            f(next->value);
+            if(std::atomic_compare_exchange_strong(&current, &expected, Ptr(next))){
+                break;
+            }
+            ++retries;
+        }
+        _commits.fetch_add(1, std::memory_order_relaxed);
+        _retries.fetch_add(retries, std::memory_order_relaxed);
+        return retries;
+    }
+
+    /*
+     * Totals over all updates, to judge the amount of contention.
+     */
+    uint64_t commits() const { return _commits.load(std::memory_order_relaxed); }
+    uint64_t retries() const { return _retries.load(std::memory_order_relaxed); }
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <fn/actor.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("actor")
+{
+    SECTION("runs_posted_functors_on_owner_thread")
+    {
+        actor<std::vector<int>> a;
+
+        auto id = a.post([](std::vector<int>&){ return std::this_thread::get_id(); });
+        CHECK(id.get() != std::this_thread::get_id());
+
+        std::vector<std::future<size_t>> sizes;
+        for(int i = 0; i < 100; ++i){
+            sizes.push_back(a.post([i](std::vector<int>& v){
+                v.push_back(i);
+                return v.size();
+            }));
+        }
+        for(size_t i = 0; i < sizes.size(); ++i){
+            CHECK(sizes[i].get() == i+1);
+        }
+    }
+
+    SECTION("void_and_reference_results")
+    {
+        actor<std::string> a("abc");
+
+        auto done = a.post([](std::string& s){ s += "d"; });
+        done.get();
+
+        auto copy = a.post([](std::string& s) -> std::string& { return s; });
+        CHECK("abcd" == copy.get());
+    }
+
+    SECTION("exceptions_are_forwarded")
+    {
+        actor<int> a(0);
+        auto r = a.post([](int&) -> int { throw std::runtime_error("boom"); });
+        CHECK_THROWS_AS(r.get(), std::runtime_error const&);
+        CHECK(1 == a.post([](int& x){ return ++x; }).get());
+    }
+
+    SECTION("many_producers")
+    {
+        std::future<int> last;
+        {
+            actor<int,64> a(0);
+            std::vector<std::thread> threads;
+            for(int t = 0; t < 4; ++t){
+                threads.emplace_back([&]{
+                    for(int i = 0; i < 1000; ++i){
+                        while(!a.post([](int& x){ ++x; }).valid()){
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for(auto& t: threads){ t.join(); }
+            last = a.post([](int& x){ return x; });
+        }
+        CHECK(4000 == last.get());
+    }
+}
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <fn/aligned_slice.hpp>
+#include <utility>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+typedef aligned_slice<float,32> float32;
+typedef aligned_slice<uint8_t,2*1024*1024> huge;
+typedef aligned_slice<uint32_t,16> u16;
+typedef aligned_slice<uint32_t,4> u4;
+
+TEST_CASE("aligned_buffer")
+{
+    aligned_buffer<float,32> b(100);
+    REQUIRE(100 == b.size());
+    CHECK(float32::is_aligned(b.data()));
+    CHECK(0.0f == ~b[99]);
+    CHECK_FALSE(b[100].valid());
+
+    for(auto& x: b){ x = 1.5f; }
+    float32 a = b;
+    CHECK(100 == a.size());
+    CHECK(1.5f == ~a[10]);
+
+    slice<float> s = b;
+    CHECK(100 == s.size());
+
+    SECTION("move"){
+        auto const p = b.data();
+        aligned_buffer<float,32> c(std::move(b));
+        CHECK(p == c.data());
+        CHECK(0 == b.size());
+    }
+
+    SECTION("hugepage"){
+        aligned_buffer<uint8_t> h(3*1024*1024, true);
+        CHECK(huge::is_aligned(h.data()));
+        CHECK(0 == ~h[3*1024*1024-1]);
+    }
+
+    SECTION("empty"){
+        aligned_buffer<double> e(0);
+        CHECK(0 == e.size());
+        CHECK(0 == e.get().size());
+    }
+}
+
+TEST_CASE("aligned_slice")
+{
+    aligned_buffer<uint32_t,16> b(64);
+    auto const s = slice<uint32_t>(b);
+
+    CHECK(u16::from(s).valid());
+    CHECK_FALSE(u16::from(s.subslice(1)).valid());
+    CHECK(u4::from(s.subslice(1)).valid());
+
+    auto const a = b.get();
+    CHECK(60 == a.subslice<4>().size());
+    CHECK(u16::is_aligned(a.subslice<4>().data()));
+
+    CHECK(a.subslice(8).valid());
+    CHECK_FALSE(a.subslice(3).valid());
+    CHECK(56 == (a.subslice(8) >>[](u16 x){ return x.size(); } | 0));
+
+    CHECK(10 == a.first(10).size());
+    auto const p = a.first(10).data();
+    CHECK(p == b.data());
+}
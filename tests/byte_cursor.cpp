@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <fn/byte_cursor.hpp>
+#include <tuple>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("byte_reader")
+{
+    uint8_t const data[] = {
+        0x01,
+        0x02, 0x03,
+        0x04, 0x05, 0x06, 0x07,
+        0xe5, 0x8e, 0x26,
+        0x03, 'a', 'b', 'c',
+    };
+    byte_reader r(slice<uint8_t const>(data, sizeof(data)));
+
+    SECTION("fixed_width")
+    {
+        CHECK(0x01 == ~r.read<uint8_t>());
+        CHECK(0x0302 == ~r.read<uint16_t>());
+        auto const be = r.read<uint32_t,byte_order::big>();
+        CHECK(0x04050607 == ~be);
+        CHECK(7 == r.position());
+        CHECK_FALSE(r.read<uint64_t>().valid());
+        CHECK(7 == r.position());
+        CHECK(624485 == ~r.varint());
+        CHECK(4 == r.remaining());
+    }
+
+    SECTION("fields")
+    {
+        auto const f = r.fields<byte_order::big, uint8_t, uint16_t, int32_t>();
+        REQUIRE(f.valid());
+        CHECK(0x01 == std::get<0>(~f));
+        CHECK(0x0203 == std::get<1>(~f));
+        CHECK(0x04050607 == std::get<2>(~f));
+        CHECK(7 == r.position());
+
+        auto const g = r.fields<byte_order::little, uint32_t, uint32_t>();
+        CHECK_FALSE(g.valid());
+        CHECK(7 == r.position());
+    }
+
+    SECTION("prefixed")
+    {
+        r.skip(10);
+        auto const b = r.prefixed<uint8_t>();
+        REQUIRE(b.valid());
+        CHECK(3 == (~b).size());
+        CHECK('c' == ~(~b)[2]);
+        auto const p = (~b).data();
+        CHECK(p == data + 11);
+        CHECK(r.empty());
+    }
+
+    SECTION("underrun")
+    {
+        r.skip(10);
+        byte_reader short_reader(r.rest().first(3));
+        CHECK_FALSE(short_reader.prefixed<uint8_t>().valid());
+        CHECK(0 == short_reader.position());
+        CHECK_FALSE(short_reader.bytes(4).valid());
+        CHECK(short_reader.bytes(3).valid());
+        CHECK_FALSE(short_reader.varint().valid());
+    }
+}
+
+TEST_CASE("byte_writer")
+{
+    uint8_t buf[32] = {};
+    byte_writer w(slice<uint8_t>(buf, sizeof(buf)));
+
+    REQUIRE(w.write(uint8_t(1)));
+    REQUIRE(w.write<byte_order::big>(uint16_t(0x0203)));
+    REQUIRE(w.fields<byte_order::little>(uint32_t(0x07060504), int16_t(-2)));
+    REQUIRE(w.varint(624485));
+    REQUIRE(w.svarint(-123456));
+    uint8_t const text[] = {'x', 'y'};
+    auto const written = w.prefixed<uint16_t,byte_order::big>(slice<uint8_t const>(text, 2));
+    REQUIRE(written);
+    REQUIRE(w.prefixed_varint(slice<uint8_t const>(text, 2)));
+
+    CHECK(0x02 == buf[1]);
+    CHECK(0x04 == buf[3]);
+    CHECK(0xfe == buf[7]);
+    CHECK(0xe5 == buf[9]);
+
+    byte_reader r(w.written());
+    CHECK(1 == ~r.read<uint8_t>());
+    auto const be = r.read<uint16_t,byte_order::big>();
+    CHECK(0x0203 == ~be);
+    CHECK(0x07060504 == ~r.read<uint32_t>());
+    CHECK(-2 == ~r.read<int16_t>());
+    CHECK(624485 == ~r.varint());
+    CHECK(-123456 == ~r.svarint());
+    auto const prefixed = r.prefixed<uint16_t,byte_order::big>();
+    CHECK(2 == (~prefixed).size());
+    CHECK('y' == ~(~r.prefixed_varint())[1]);
+    CHECK(r.empty());
+
+    SECTION("overflow")
+    {
+        byte_writer small(slice<uint8_t>(buf, 3));
+        CHECK(small.write(uint16_t(1)));
+        CHECK_FALSE(small.write(uint16_t(1)));
+        CHECK_FALSE(small.fields<byte_order::little>(uint8_t(1), uint8_t(2)));
+        CHECK_FALSE(small.prefixed_varint(slice<uint8_t const>(text, 2)));
+        CHECK(2 == small.position());
+    }
+
+    SECTION("svarint_edges")
+    {
+        byte_writer e(slice<uint8_t>(buf, sizeof(buf)));
+        int64_t const values[] = {0, 1, -1, 63, -64, 64, -65, INT64_MAX, INT64_MIN};
+        for(auto v: values){ REQUIRE(e.svarint(v)); }
+        byte_reader d(e.written());
+        for(auto v: values){ CHECK(v == ~d.svarint()); }
+        CHECK(d.empty());
+    }
+}
@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <cstring>
+#include <fn/byte_ring.hpp>
+#include <unistd.h>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+static slice<uint8_t const> bytes(char const* s)
+{
+    return slice<uint8_t const>(reinterpret_cast<uint8_t const*>(s), strlen(s));
+}
+
+TEST_CASE("byte_ring")
+{
+    byte_ring r(6);
+    REQUIRE(8 == r.capacity());
+    REQUIRE(r.empty());
+    REQUIRE(8 == r.space());
+
+    SECTION("write_read")
+    {
+        CHECK(5 == r.write(bytes("hello")));
+        CHECK(5 == r.size());
+        CHECK(5 == r.readable().first.size());
+        CHECK(0 == r.readable().second.size());
+
+        uint8_t out[3];
+        CHECK(3 == r.read(slice<uint8_t>(out, 3)));
+        CHECK('l' == out[2]);
+        CHECK(2 == r.size());
+    }
+
+    SECTION("wrap_around")
+    {
+        r.write(bytes("abcdef"));
+        r.consume(4);
+        CHECK(6 == r.write(bytes("ghijklmn")));
+        CHECK(8 == r.size());
+        CHECK(0 == r.space());
+
+        auto const parts = r.readable();
+        CHECK(4 == parts.first.size());
+        CHECK(4 == parts.second.size());
+        CHECK('e' == ~parts.first[0]);
+        CHECK('i' == ~parts.second[0]);
+
+        iovec v[2];
+        CHECK(2 == parts.iovecs(v));
+        CHECK(0 == r.writable().iovecs(v));
+
+        uint8_t out[8];
+        CHECK(8 == r.read(slice<uint8_t>(out, 8)));
+        CHECK('e' == out[0]);
+        CHECK('l' == out[7]);
+        CHECK(r.empty());
+    }
+
+    SECTION("commit_consume")
+    {
+        auto const w = r.writable();
+        w.first.first(3).fill('x');
+        r.commit(3);
+        CHECK(3 == r.size());
+        r.consume(10);
+        CHECK(r.empty());
+        // an empty ring starts over in one piece
+        CHECK(8 == r.writable().first.size());
+    }
+
+    SECTION("file_descriptors")
+    {
+        int fds[2];
+        REQUIRE(0 == pipe(fds));
+
+        r.write(bytes("abcdef"));
+        r.consume(5);
+        r.write(bytes("ghijk"));
+        CHECK(6 == r.write_to(fds[1]));
+        CHECK(r.empty());
+
+        byte_ring in(4);
+        CHECK(4 == in.read_from(fds[0]));
+        CHECK('f' == ~in.readable().first[0]);
+        in.consume(3);
+        CHECK(2 == in.read_from(fds[0]));
+        auto const parts = in.readable();
+        CHECK(3 == parts.size());
+        CHECK('i' == ~parts.first[0]);
+        CHECK('k' == ~parts.second[1]);
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
@@ -274,3 +274,18 @@ TEST_CASE("Ring remove_if")
         CHECK(2 == M::counter);
     }
 }
+
+TEST_CASE("Channel batch receive")
+{
+    auto channel = Channel<int>(10);
+    std::vector<int> out;
+
+    CHECK(0 == channel.receive.batch(0,out,5));
+
+    for(int i = 0; i < 7; ++i){ channel.send(i); }
+
+    CHECK(5 == channel.receive.batch(0,out,5));
+    CHECK(2 == channel.receive.batch(0,out,5));
+    REQUIRE(7 == out.size());
+    for(int i = 0; i < 7; ++i){ CHECK(i == out[i]); }
+}
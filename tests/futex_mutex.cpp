@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <fn/futex_mutex.hpp>
+#include <fn/synchronized.hpp>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+template<typename Mutex>
+static void check_mutex()
+{
+    {
+        Mutex m;
+        REQUIRE(m.try_lock());
+        REQUIRE_FALSE(m.try_lock());
+        m.unlock();
+        m.lock();
+        REQUIRE_FALSE(m.try_lock());
+        m.unlock();
+        REQUIRE(m.try_lock());
+        m.unlock();
+    }
+
+    {
+        synchronized<int,Mutex> x(0);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&]{
+                for(int i = 0; i < 10000; ++i){
+                    x >>[](int& x){ ++x; };
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+        REQUIRE(40000 == *x.guard());
+    }
+
+    {
+        synchronized<int,Mutex> a(100);
+        synchronized<int,Mutex> b(100);
+        std::thread t([&]{
+            for(int i = 0; i < 1000; ++i){
+                synchronize(a,b) >>[](int& a, int& b){ --a; ++b; };
+            }
+        });
+        for(int i = 0; i < 1000; ++i){
+            synchronize(b,a) >>[](int& b, int& a){ --b; ++a; };
+        }
+        t.join();
+        REQUIRE(100 == *a.guard());
+        REQUIRE(100 == *b.guard());
+    }
+}
+
+TEST_CASE("ticket_spinlock")
+{
+    check_mutex<ticket_spinlock>();
+}
+
+TEST_CASE("adaptive_mutex")
+{
+    check_mutex<adaptive_mutex>();
+}
+
+TEST_CASE("mcs_lock")
+{
+    check_mutex<mcs_lock>();
+}
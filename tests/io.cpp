@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <cstring>
+#include <fn/io.hpp>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+static slice<uint8_t const> bytes(char const* s)
+{
+    return slice<uint8_t const>(reinterpret_cast<uint8_t const*>(s), strlen(s));
+}
+
+TEST_CASE("io")
+{
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+
+    SECTION("write_all_read_into")
+    {
+        REQUIRE(io::write_all(fds[1], {bytes("head"), bytes(""), bytes("er-"), bytes("body")}));
+
+        uint8_t a[3];
+        uint8_t b[8];
+        auto const n = io::read_into(fds[0], {slice<uint8_t>(a, 3), slice<uint8_t>(b, 8)});
+        // the pipe returns what is there
+        REQUIRE(n.valid());
+        CHECK(11 == ~n);
+        CHECK('h' == a[0]);
+        CHECK('d' == b[0]);
+        CHECK('y' == b[7]);
+    }
+
+    SECTION("more_slices_than_iov_max")
+    {
+        std::vector<std::vector<uint8_t>> chunks;
+        std::vector<slice<uint8_t const>> slices;
+        for(int i = 0; i < 3000; ++i){
+            chunks.push_back(std::vector<uint8_t>(100, uint8_t(i)));
+        }
+        for(auto& c: chunks){ slices.push_back(make_slice(c)); }
+
+        std::vector<uint8_t> in(300000);
+        optional<size_t> got;
+        std::thread reader([&]{
+            got = io::read_into(fds[0], std::vector<slice<uint8_t>>{make_slice(in)});
+        });
+
+        REQUIRE(io::write_all(fds[1], slices));
+        close(fds[1]);
+        fds[1] = -1;
+        reader.join();
+
+        REQUIRE(got.valid());
+        CHECK(300000 == ~got);
+        CHECK(0 == in[0]);
+        CHECK(uint8_t(1234) == in[123450]);
+        CHECK(uint8_t(2999) == in[299999]);
+    }
+
+    SECTION("end_of_input")
+    {
+        REQUIRE(io::write_all(fds[1], {bytes("abc")}));
+        close(fds[1]);
+        fds[1] = -1;
+
+        uint8_t a[8];
+        auto const n = io::read_into(fds[0], {slice<uint8_t>(a, 2), slice<uint8_t>(a+2, 6)});
+        CHECK(3 == ~n);
+        CHECK('c' == a[2]);
+    }
+
+    SECTION("error")
+    {
+        CHECK_FALSE(io::write_all(-1, {bytes("x")}));
+        uint8_t a[1];
+        CHECK_FALSE(io::read_into(-1, {slice<uint8_t>(a, 1)}).valid());
+        CHECK(io::write_all(-1, {bytes("")}));
+    }
+
+    close(fds[0]);
+    if(fds[1] >= 0){ close(fds[1]); }
+}
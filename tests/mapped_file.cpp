@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <fn/mapped_file.hpp>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+struct Record
+{
+    uint32_t id;
+    uint32_t value;
+};
+
+static std::string write_temp(std::vector<uint8_t> const& content)
+{
+    char path[] = "/tmp/fn_mapped_file_XXXXXX";
+    auto const fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    if(!content.empty()){
+        REQUIRE(ssize_t(content.size()) == ::write(fd, content.data(), content.size()));
+    }
+    ::close(fd);
+    return path;
+}
+
+TEST_CASE("mapped_file")
+{
+    std::vector<Record> records = {{1,10},{2,20},{3,30}};
+    std::vector<uint8_t> content(
+        reinterpret_cast<uint8_t const*>(records.data()),
+        reinterpret_cast<uint8_t const*>(records.data() + records.size())
+    );
+    content.push_back(0xff);
+    auto const path = write_temp(content);
+
+    SECTION("bytes"){
+        mapped_file f(path);
+        REQUIRE(25 == f.size());
+        auto const b = f.bytes();
+        REQUIRE(25 == b.size());
+        CHECK(1 == ~b[0]);
+        CHECK(0xff == ~b[24]);
+    }
+
+    SECTION("records"){
+        mapped_file f(path);
+        auto const r = f.as<Record>();
+        REQUIRE(3 == r.size());
+        CHECK(20 == (r[1] >>[](Record const& x){ return x.value; } | 0U));
+
+        uint32_t sum = 0;
+        for(auto const& x: r){ sum += x.value; }
+        CHECK(60 == sum);
+    }
+
+    SECTION("advise"){
+        mapped_file f(path);
+        CHECK(f.advise(advice::sequential));
+        CHECK(f.advise(advice::willneed, 8, 8));
+        CHECK_FALSE(f.advise(advice::normal, 100));
+    }
+
+    SECTION("move"){
+        mapped_file f(path);
+        auto const p = f.data();
+        mapped_file g(std::move(f));
+        CHECK(0 == f.size());
+        CHECK(p == g.data());
+        CHECK(0xff == ~g.bytes()[24]);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("mapped_file of an empty file")
+{
+    auto const path = write_temp({});
+    {
+        mapped_file f(path);
+        CHECK(0 == f.size());
+        CHECK(0 == f.bytes().size());
+        CHECK(0 == f.as<Record>().size());
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("mapped_file of a missing file")
+{
+    CHECK_THROWS_AS(mapped_file("/nonexistent/fn_mapped_file"), std::system_error const&);
+}
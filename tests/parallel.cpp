@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <fn/parallel.hpp>
+#include <stdexcept>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("parallel")
+{
+    std::vector<uint64_t> v(1000000);
+    for(size_t i = 0; i < v.size(); ++i){ v[i] = i; }
+    auto const s = make_slice(v);
+    auto const plus = [](uint64_t a, uint64_t b){ return a+b; };
+
+    SECTION("reduce")
+    {
+        CHECK(499999500000ULL == parallel_reduce(s, uint64_t(0), plus));
+        CHECK(499999500000ULL == parallel_reduce(s, uint64_t(0), plus, plus, 1000));
+        CHECK(0 == parallel_reduce(s.first(0), uint64_t(0), plus));
+    }
+
+    SECTION("reduce_is_deterministic")
+    {
+        std::vector<float> f(100000);
+        for(size_t i = 0; i < f.size(); ++i){ f[i] = 1.0f / float(i+1); }
+        auto const sum = [](float a, float b){ return a+b; };
+
+        auto const first = parallel_reduce(make_slice(f), 0.0f, sum, sum, 1024);
+        for(int i = 0; i < 10; ++i){
+            auto const again = parallel_reduce(make_slice(f), 0.0f, sum, sum, 1024);
+            CHECK(first == again);
+        }
+    }
+
+    SECTION("for_each")
+    {
+        parallel_for_each(s, [](uint64_t& x){ x *= 2; }, 4096);
+        CHECK(0 == v[0]);
+        CHECK(2 == v[1]);
+        CHECK(1999998 == v[999999]);
+        CHECK(999999000000ULL == parallel_reduce(s, uint64_t(0), plus));
+    }
+
+    SECTION("nested")
+    {
+        std::vector<uint64_t> sums(8);
+        parallel_for_each(make_slice(sums), [&](uint64_t& x){
+            x = parallel_reduce(s, uint64_t(0), plus, plus, 10000);
+        }, 1);
+        for(auto x: sums){
+            CHECK(499999500000ULL == x);
+        }
+    }
+
+    SECTION("exception")
+    {
+        CHECK_THROWS_AS(
+            parallel_for_each(s, [](uint64_t& x){
+                if(x == 123456){ throw std::runtime_error("bad"); }
+            }, 1000),
+            std::runtime_error const&
+        );
+        // the pool is still usable
+        CHECK(499999500000ULL == parallel_reduce(s, uint64_t(0), plus));
+    }
+}
+
+TEST_CASE("WorkPool")
+{
+    fn_::WorkPool pool(3);
+    REQUIRE(4 == pool.concurrency());
+
+    std::vector<int> hits(1000);
+    for(int round = 0; round < 50; ++round){
+        pool.run(hits.size(), [&](size_t const i){ ++hits[i]; });
+    }
+    for(auto h: hits){
+        CHECK(50 == h);
+    }
+
+    CHECK_THROWS_AS(
+        pool.run(100, [](size_t const i){
+            if(i == 42){ throw std::runtime_error("bad"); }
+        }),
+        std::runtime_error const&
+    );
+
+    int nested = 0;
+    pool.run(1, [&](size_t){
+        pool.run(10, [&](size_t){ ++nested; });
+    });
+    CHECK(10 == nested);
+}
@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <cstring>
+#include <fn/profiled_mutex.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+static lock_stats stats_of(char const* name)
+{
+    for(auto const& s: lock_stats_all()){
+        if(s.name && 0 == strcmp(s.name, name)){ return s; }
+    }
+    lock_stats none = {};
+    return none;
+}
+
+TEST_CASE("profiled")
+{
+    SECTION("counts_acquisitions")
+    {
+        synchronized<int,profiled<>> x(5);
+        x.get_mutex().name("counts_acquisitions");
+
+        for(int i = 0; i < 10; ++i){
+            x >>[](int& x){ ++x; };
+        }
+        REQUIRE(15 == *x.guard());
+
+        auto const s = stats_of("counts_acquisitions");
+        CHECK(11 == s.acquisitions);
+        CHECK(0 == s.contended);
+        CHECK(0 == s.wait_ns);
+
+        uint64_t held = 0;
+        for(auto h: s.hold_histogram){ held += h; }
+        CHECK(11 == held);
+    }
+
+    SECTION("counts_contention")
+    {
+        synchronized<int,profiled<>> x(0);
+        x.get_mutex().name("counts_contention");
+
+        std::thread t;
+        {
+            auto g = x.guard();
+            t = std::thread([&]{ x >>[](int& x){ ++x; }; });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        t.join();
+
+        auto const s = stats_of("counts_contention");
+        CHECK(2 == s.acquisitions);
+        CHECK(1 == s.contended);
+        CHECK(s.max_wait_ns >= 1000000);
+        CHECK(s.wait_ns == s.max_wait_ns);
+        CHECK(s.hold_ns >= 1000000);
+    }
+
+    SECTION("unregisters_on_destruction")
+    {
+        {
+            profiled<> m("unregisters_on_destruction");
+            CHECK(0 != stats_of("unregisters_on_destruction").name);
+        }
+        CHECK(0 == stats_of("unregisters_on_destruction").name);
+    }
+
+    SECTION("dump")
+    {
+        profiled<> m("dumped");
+        m.lock();
+        m.unlock();
+
+        std::ostringstream out;
+        dump_lock_stats(out);
+        CHECK(std::string::npos != out.str().find("dumped: 1 acquisitions, 0 contended"));
+    }
+}
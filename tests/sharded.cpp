@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <fn/sharded.hpp>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+struct Histogram
+{
+    std::vector<int> buckets;
+    Histogram(): buckets(4) {}
+};
+
+struct MergeHistograms
+{
+    Histogram operator()(Histogram a, Histogram const& b) const
+    {
+        for(size_t i = 0; i < a.buckets.size(); ++i){
+            a.buckets[i] += b.buckets[i];
+        }
+        return a;
+    }
+};
+
+TEST_CASE("sharded")
+{
+    SECTION("sum_over_threads")
+    {
+        sharded<uint64_t> hits;
+        CHECK(0 == hits.collect());
+
+        hits >>[](uint64_t& h){ ++h; };
+        CHECK(1 == hits.collect());
+
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&]{
+                for(int i = 0; i < 10000; ++i){
+                    hits >>[](uint64_t& h){ ++h; };
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+        CHECK(40001 == hits.collect());
+    }
+
+    SECTION("custom_combine")
+    {
+        sharded<Histogram,MergeHistograms> h;
+
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&,t]{
+                for(int i = 0; i < 100; ++i){
+                    h >>[&](Histogram& h){ h.buckets[t]++; };
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+
+        auto const all = h.collect();
+        for(int b: all.buckets){ CHECK(100 == b); }
+    }
+
+    SECTION("neutral_and_max")
+    {
+        auto const max = [](int a, int b){ return std::max(a,b); };
+        sharded<int,decltype(max)> m(-1, max);
+        CHECK(-1 == m.collect());
+
+        std::thread t([&]{ m >>[](int& x){ x = 7; }; });
+        t.join();
+        m >>[](int& x){ x = 3; };
+        CHECK(7 == m.collect());
+    }
+}
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <fn/sharded_synchronized.hpp>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+typedef std::unordered_map<int,int> Map;
+
+TEST_CASE("sharded_synchronized")
+{
+    sharded_synchronized<Map,8> m;
+
+    for(int i = 0; i < 100; ++i){
+        m[i] >>[&](Map& s){ s[i] = 2*i; };
+    }
+
+    SECTION("lookup_by_key")
+    {
+        for(int i = 0; i < 100; ++i){
+            auto v = m[i] >>[&](Map& s) -> int& { return s.at(i); };
+            v >>[&](int& v){ CHECK(v == 2*i); };
+        }
+    }
+
+    SECTION("keys_are_spread_over_shards")
+    {
+        size_t used = 0;
+        m.for_all([&](Map& s){
+            if(!s.empty()){ ++used; }
+        });
+        CHECK(8 == used);
+    }
+
+    SECTION("for_all_sees_everything")
+    {
+        size_t count = 0;
+        int sum = 0;
+        auto const& c = m;
+        c.for_all([&](Map const& s){
+            count += s.size();
+            for(auto& kv: s){ sum += kv.second; }
+        });
+        CHECK(100 == count);
+        CHECK(9900 == sum);
+    }
+
+    SECTION("concurrent_updates")
+    {
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&]{
+                for(int n = 0; n < 1000; ++n){
+                    auto const k = n % 100;
+                    m[k] >>[&](Map& s){ s[k] += 1; };
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+
+        int sum = 0;
+        m.for_all([&](Map& s){
+            for(auto& kv: s){ sum += kv.second; }
+        });
+        CHECK(13900 == sum);
+    }
+}
+
+TEST_CASE("sharded_synchronized, alignment")
+{
+    CHECK(0 == sizeof(sharded_synchronized<Map,4>) % fn_::cache_line_size);
+    CHECK(sizeof(sharded_synchronized<Map,4>) >= 4*fn_::cache_line_size);
+}
@@ -1,7 +1,11 @@
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <thread>
 #include <fn/shared.hpp>
 #include <vector>
 #include <map>
+#include <memory>
 #include <utility>
 #include "catch.hpp"
 using namespace fn;
@@ -90,4 +94,160 @@ TEST_CASE("chained")
 
     CHECK(2 == b.count());
     CHECK(2 == c.count());
+
+    SECTION("invalidate_all")
+    {
+        CHECK(b.current());
+        CHECK(c.current());
+
+        b.invalidate_all();
+        CHECK_FALSE(b.current());
+        CHECK_FALSE(c.current());
+
+        auto d = c;
+        CHECK_FALSE(d.current());
+        CHECK(3 == b.count());
+
+        fn_::chained e;
+        CHECK(e.current());
+        CHECK(1 == e.count());
+    }
+}
+
+TEST_CASE("A shared value with many refs")
+{
+    auto i = std::unique_ptr<shared<int>>(new shared<int>(1));
+    std::vector<std::unique_ptr<ref<int>>> refs;
+    for(int n = 0; n < 1000; ++n){
+        refs.emplace_back(new ref<int>(*i));
+    }
+    CHECK(1 == ~*refs.front());
+
+    // the newest ref goes away before the shared value
+    refs.pop_back();
+    ref<int> copy(*refs.back());
+
+    i.reset(nullptr);
+    for(auto const& r: refs){
+        CHECK_FALSE(r->valid());
+    }
+    CHECK_FALSE(copy.valid());
+
+    ref<int> late(copy);
+    CHECK_FALSE(late.valid());
+    CHECK(-1 == (late | -1));
+}
+
+TEST_CASE("A shared value with ref_cell storage")
+{
+    auto i = std::unique_ptr<shared<int,ref_cell>>(new shared<int,ref_cell>(5));
+    CHECK(5 == *i);
+
+    ref<int,ref_cell> unset;
+    CHECK_FALSE(unset.valid());
+
+    ref<int,ref_cell> r(*i);
+    ref<int,ref_cell> r2(r);
+    unset = r2;
+
+    CHECK(5 == ~r);
+    CHECK(5 == ~r2);
+    CHECK(5 == ~unset);
+
+    (*i)++;
+    CHECK(6 == ~r);
+    CHECK(6 == (r >>[](int& x){ return x; } | 0));
+
+    SECTION("delete"){
+        i.reset(nullptr);
+        CHECK_FALSE(r.valid());
+        CHECK_FALSE(r2.valid());
+        CHECK(-1 == (r | -1));
+    }
+
+    SECTION("move"){
+        auto j = std::move(*i);
+        i.reset(nullptr);
+        CHECK(r.valid());
+
+        j++;
+        CHECK(7 == ~r);
+        CHECK(7 == ~r2);
+        CHECK(7 == ~unset);
+    }
+
+    SECTION("relocate_in_vector"){
+        std::vector<shared<int,ref_cell>> v;
+        std::vector<ref<int,ref_cell>> refs;
+        for(int n = 0; n < 100; ++n){
+            v.push_back(shared<int,ref_cell>(n));
+            refs.push_back(ref<int,ref_cell>(v.back()));
+        }
+        for(int n = 0; n < 100; ++n){
+            CHECK(n == ~refs[n]);
+        }
+        v.clear();
+        for(auto& r: refs){
+            CHECK_FALSE(r.valid());
+        }
+    }
+}
+
+TEST_CASE("A shared value with ref_atomic storage")
+{
+    auto i = std::unique_ptr<shared<int,ref_atomic>>(new shared<int,ref_atomic>(5));
+
+    ref<int,ref_atomic> unset;
+    CHECK_FALSE(unset.valid());
+
+    ref<int,ref_atomic> r(*i);
+    unset = r;
+    CHECK(5 == ~r);
+    CHECK(5 == ~unset);
+    CHECK(5 == (r >>[](int& x){ return x; } | 0));
+
+    SECTION("refs_from_threads"){
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&]{
+                for(int n = 0; n < 1000; ++n){
+                    ref<int,ref_atomic> local(r);
+                    local.pin() >>[](int& x){ return x; };
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+        CHECK(5 == ~r);
+    }
+
+    SECTION("pin_blocks_destruction"){
+        std::atomic<bool> destroyed(false);
+        std::thread destroyer;
+        {
+            auto p = r.pin();
+            REQUIRE(p.valid());
+            destroyer = std::thread([&]{
+                i.reset(nullptr);
+                destroyed = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            CHECK_FALSE(destroyed);
+            CHECK(5 == ~p);
+        }
+        destroyer.join();
+        CHECK(destroyed);
+        CHECK_FALSE(r.valid());
+        CHECK_FALSE(unset.pin().valid());
+        CHECK(-1 == (r | -1));
+    }
+
+    SECTION("move"){
+        auto j = std::move(*i);
+        i.reset(nullptr);
+        CHECK(r.valid());
+
+        j = 7;
+        CHECK(7 == ~r);
+        CHECK(7 == ~unset);
+    }
 }
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <fn/shared_pool.hpp>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("shared_pool")
+{
+    shared_pool<std::string,ref_chain,4> pool;
+    CHECK(0 == pool.size());
+    CHECK(0 == pool.capacity());
+
+    auto& a = pool.make("a");
+    auto& b = pool.make(3, 'b');
+    ref<std::string> ra(a);
+    ref<std::string> rb(b);
+
+    CHECK("a" == ~ra);
+    CHECK("bbb" == ~rb);
+    CHECK(2 == pool.size());
+    CHECK(4 == pool.capacity());
+
+    // slots of a slab are handed out in order
+    CHECK(reinterpret_cast<char*>(&b) > reinterpret_cast<char*>(&a));
+
+    SECTION("destroy_and_reuse"){
+        pool.destroy(a);
+        CHECK_FALSE(ra.valid());
+        CHECK("bbb" == ~rb);
+        CHECK(1 == pool.size());
+
+        auto& c = pool.make("c");
+        CHECK(&c == &a);
+        CHECK_FALSE(ra.valid());
+        CHECK(4 == pool.capacity());
+    }
+
+    SECTION("grow"){
+        std::vector<ref<std::string>> refs;
+        for(int i = 0; i < 10; ++i){
+            refs.emplace_back(pool.make(std::to_string(i)));
+        }
+        CHECK(12 == pool.size());
+        CHECK(12 == pool.capacity());
+
+        std::string all;
+        pool.for_all([&](shared<std::string>& s){ all += s; });
+        CHECK("abbb0123456789" == all);
+    }
+
+    SECTION("clear"){
+        pool.clear();
+        CHECK_FALSE(ra.valid());
+        CHECK_FALSE(rb.valid());
+        CHECK(0 == pool.size());
+        CHECK(0 == pool.capacity());
+    }
+}
+
+TEST_CASE("shared_pool with ref_cell storage")
+{
+    ref<int,ref_cell> r;
+    {
+        shared_pool<int,ref_cell> pool;
+        r = ref<int,ref_cell>(pool.make(42));
+        CHECK(42 == ~r);
+    }
+    CHECK_FALSE(r.valid());
+}
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <iterator>
+#include <type_traits>
 #include <fn/slice.hpp>
 #include <vector>
 #include <map>
+#include <string>
 #include <utility>
 #include "catch.hpp"
 using namespace fn;
@@ -353,4 +358,250 @@ TEST_CASE("slice")
         slice<int,3> s = slice_from_pointer<3>(v.data());
         REQUIRE(3 == s.size());
     }
+
+    SECTION("fill_wide")
+    {
+        std::vector<uint32_t> v(1000, 0);
+        auto s = make_slice(v);
+        s.subslice(1).first(998).fill(0x01020304);
+
+        REQUIRE(0 == v[0]);
+        REQUIRE(0x01020304 == v[1]);
+        REQUIRE(0x01020304 == v[998]);
+        REQUIRE(0 == v[999]);
+
+        slice_from_pointer<4>(v.data()+996).fill(7);
+        REQUIRE(0x01020304 == v[995]);
+        REQUIRE(7 == v[996]);
+        REQUIRE(7 == v[999]);
+    }
+
+    SECTION("copy_non_trivial")
+    {
+        std::vector<std::string> a = {"a","b","c"};
+        std::vector<std::string> b(2);
+
+        auto const rest = make_slice(b).copy(make_slice(a));
+        REQUIRE(1 == rest.size());
+        REQUIRE("a" == b[0]);
+        REQUIRE("b" == b[1]);
+        REQUIRE("c" == ~rest[0]);
+    }
+
+    SECTION("compare")
+    {
+        std::vector<uint64_t> a(4096, 3);
+        std::vector<uint64_t> b(4096, 3);
+        auto sa = make_slice(a);
+        auto sb = make_slice(b);
+
+        REQUIRE(sa.compare(sb));
+        REQUIRE_FALSE(sa.compare(sb.first(10)));
+
+        b[4095] = 4;
+        REQUIRE_FALSE(sa.compare(sb));
+        REQUIRE(sa.first(4095).compare(sb.first(4095)));
+
+        auto fa = slice_from_pointer<4>(a.data());
+        auto fb = slice_from_pointer<4>(b.data()+4092);
+        REQUIRE_FALSE(fa.compare(fb));
+        REQUIRE(fa.compare(slice_from_pointer<4>(b.data())));
+    }
+
+    SECTION("standard_algorithms")
+    {
+        static_assert(std::is_same<
+            std::iterator_traits<slice<int>::iterator>::iterator_category,
+            std::random_access_iterator_tag
+        >::value, "slice iterators are random access");
+
+        std::vector<int> v = {5,3,9,1,7};
+        auto s = make_slice(v);
+        std::sort(s.begin(), s.end());
+        REQUIRE(1 == v[0]);
+        REQUIRE(9 == v[4]);
+
+        REQUIRE(2 == std::lower_bound(s.begin(), s.end(), 5) - s.begin());
+        REQUIRE(5 == s.end() - s.begin());
+
+        auto f = slice_from_pointer<3>(v.data()+2);
+        REQUIRE(5 == *f.begin());
+        auto const past = v.data()+5;
+        REQUIRE(past == f.end());
+
+        int sum = 0;
+        for(auto x: f){ sum += x; }
+        REQUIRE(21 == sum);
+    }
+
+    SECTION("compare_floating_point")
+    {
+        // compared by value, not by representation
+        double a[2] = {0.0, NAN};
+        double b[2] = {-0.0, NAN};
+        auto sa = slice<double>(a,2);
+        auto sb = slice<double>(b,2);
+
+        REQUIRE(sa.first(1).compare(sb.first(1)));
+        REQUIRE_FALSE(sa.compare(sa));
+    }
+}
+
+TEST_CASE("strided_slice")
+{
+    // 3 rows of 4 columns
+    std::vector<int> m = {
+        0, 1, 2, 3,
+        4, 5, 6, 7,
+        8, 9,10,11,
+    };
+    auto s = make_slice(m);
+
+    SECTION("column")
+    {
+        auto c = s.column(1,4);
+        REQUIRE(3 == c.size());
+        REQUIRE(4 == c.stride());
+        REQUIRE(1 == ~c[0]);
+        REQUIRE(9 == ~c[2]);
+        REQUIRE_FALSE(c[3].valid());
+
+        REQUIRE(15 == reduce(c, 0, [](int a, int b){ return a+b; }));
+        REQUIRE(0 == s.column(4,4).size());
+        REQUIRE(0 == s.first(2).column(3,4).size());
+    }
+
+    SECTION("stride")
+    {
+        auto e = s.stride(5);
+        REQUIRE(3 == e.size());
+        REQUIRE(10 == ~e[2]);
+
+        auto even = s.stride(2);
+        REQUIRE(6 == even.size());
+        REQUIRE(3 == even.stride(2).size());
+        REQUIRE(8 == ~even.stride(2)[2]);
+        REQUIRE(6 == ~even.subslice(1).first(3).stride(2)[1]);
+        REQUIRE(0 == s.stride(0).size());
+
+        auto f = slice_from_pointer<6>(m.data()).stride(3);
+        REQUIRE(2 == f.size());
+        REQUIRE(3 == ~f[1]);
+    }
+
+    SECTION("fill")
+    {
+        s.column(2,4).fill(-1);
+        REQUIRE(-1 == m[2]);
+        REQUIRE(-1 == m[6]);
+        REQUIRE(-1 == m[10]);
+        REQUIRE(3 == m[3]);
+        REQUIRE(11 == m[11]);
+    }
+
+    SECTION("gather_and_scatter")
+    {
+        std::vector<int> col(3);
+        auto const rest = strided_slice<int>(make_slice(col)).copy(s.column(3,4));
+        REQUIRE(0 == rest.size());
+        REQUIRE(3 == col[0]);
+        REQUIRE(11 == col[2]);
+
+        std::vector<int> src = {-1,-2,-3,-4};
+        auto const left = s.column(0,4).copy(slice<int>(src));
+        REQUIRE(1 == left.size());
+        REQUIRE(-4 == ~left[0]);
+        REQUIRE(-1 == m[0]);
+        REQUIRE(-2 == m[4]);
+        REQUIRE(-3 == m[8]);
+    }
+
+    SECTION("standard_algorithms")
+    {
+        auto c = s.column(0,4);
+        std::reverse(c.begin(), c.end());
+        REQUIRE(8 == m[0]);
+        REQUIRE(0 == m[8]);
+        REQUIRE(3 == c.end() - c.begin());
+        REQUIRE(4 == *(c.begin() + 1));
+    }
+}
+
+TEST_CASE("slice_search")
+{
+    // long enough for the vector loops and their scalar tails
+    std::vector<uint8_t> buf(100, 'a');
+    auto const s = slice<uint8_t>(buf);
+
+    SECTION("find")
+    {
+        REQUIRE_FALSE(s.find('x').valid());
+        buf[77] = 'x';
+        buf[90] = 'x';
+        REQUIRE(77 == ~s.find('x'));
+        REQUIRE_FALSE(s.first(77).find('x').valid());
+        REQUIRE_FALSE(slice<uint8_t>().find('x').valid());
+
+        std::vector<int> v = {5,6,7,6};
+        REQUIRE(1 == ~make_slice(v).find(6));
+        REQUIRE_FALSE(make_slice(v).find(8).valid());
+    }
+
+    SECTION("count")
+    {
+        REQUIRE(100 == s.count('a'));
+        REQUIRE(0 == s.count('b'));
+        for(size_t i = 0; i < buf.size(); i += 3){ buf[i] = '\n'; }
+        REQUIRE(34 == s.count('\n'));
+        REQUIRE(33 == s.subslice(1).count('\n'));
+        REQUIRE(1 == s.first(1).count('\n'));
+
+        std::vector<int> v = {1,2,1,1};
+        REQUIRE(3 == make_slice(v).count(1));
+    }
+
+    SECTION("find_any")
+    {
+        uint8_t const few_bytes[] = {',', '\n'};
+        uint8_t const many_bytes[] = {'0','1','2','3','4','5','6','7','8','9'};
+        auto const few = slice<uint8_t const>(few_bytes, 2);
+        auto const many = slice<uint8_t const>(many_bytes, 10);
+        REQUIRE_FALSE(s.find_any(few).valid());
+        REQUIRE_FALSE(s.find_any(many).valid());
+        REQUIRE_FALSE(s.find_any(slice<uint8_t const>()).valid());
+        buf[95] = '\n';
+        buf[40] = '7';
+        REQUIRE(95 == ~s.find_any(few));
+        REQUIRE(40 == ~s.find_any(many));
+        buf[20] = ',';
+        REQUIRE(20 == ~s.find_any(few));
+
+        std::vector<int> v = {4,3,2,1};
+        std::vector<int> set = {1,2};
+        REQUIRE(2 == ~make_slice(v).find_any(make_slice(set)));
+    }
+
+    SECTION("substring")
+    {
+        std::string const needle = "\r\n\r\n";
+        auto const n = slice<uint8_t const>(reinterpret_cast<uint8_t const*>(needle.data()), needle.size());
+        REQUIRE_FALSE(s.find(n).valid());
+        REQUIRE(0 == ~s.find(slice<uint8_t const>()));
+        std::copy(needle.begin(), needle.end(), buf.begin() + 60);
+        REQUIRE(60 == ~s.find(n));
+        REQUIRE_FALSE(s.first(63).find(n).valid());
+
+        std::vector<int> v = {1,2,1,2,3};
+        std::vector<int> w = {1,2,3};
+        REQUIRE(2 == ~make_slice(v).find(make_slice(w)));
+        REQUIRE_FALSE(make_slice(w).find(make_slice(v)).valid());
+    }
+
+    SECTION("fixed")
+    {
+        auto const f = slice<uint8_t,100>::from_pointer(buf.data());
+        buf[50] = 'z';
+        REQUIRE(50 == ~f.find('z'));
+        REQUIRE(1 == f.count('z'));
+    }
 }
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <fn/slice_nd.hpp>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("slice_nd")
+{
+    // 3 rows of 4 columns
+    std::vector<int> v = {
+        0, 1, 2, 3,
+        4, 5, 6, 7,
+        8, 9,10,11,
+    };
+    slice2d<int> m(make_slice(v),{{3,4}});
+
+    REQUIRE(3 == m.size(0));
+    REQUIRE(4 == m.size(1));
+    REQUIRE(4 == m.stride(0));
+    REQUIRE(12 == m.count());
+
+    SECTION("index")
+    {
+        REQUIRE(6 == ~m(1,2));
+        slice2d<int>::index const i = {{2,3}};
+        REQUIRE(11 == ~m[i]);
+        REQUIRE_FALSE(m(3,0).valid());
+        REQUIRE_FALSE(m(0,4).valid());
+    }
+
+    SECTION("too_small")
+    {
+        slice2d<int> e(make_slice(v),{{4,4}});
+        REQUIRE(0 == e.count());
+        REQUIRE_FALSE(e(0,0).valid());
+    }
+
+    SECTION("rows_and_columns")
+    {
+        REQUIRE(4 == ~m.row(1)[0]);
+        REQUIRE(0 == m.row(3).size());
+        REQUIRE(9 == ~m.column(1)[2]);
+
+        int n = 0;
+        int sum = 0;
+        m.rows([&](slice<int> r){
+            ++n;
+            sum += ~r[0];
+        });
+        REQUIRE(3 == n);
+        REQUIRE(12 == sum);
+    }
+
+    SECTION("subslice")
+    {
+        auto s = m.subslice({{1,1}},{{5,2}});
+        REQUIRE(2 == s.size(0));
+        REQUIRE(2 == s.size(1));
+        REQUIRE(5 == ~s(0,0));
+        REQUIRE(10 == ~s(1,1));
+        REQUIRE_FALSE(s(0,2).valid());
+
+        s.rows([](slice<int> r){ r.fill(0); });
+        REQUIRE(0 == v[5]);
+        REQUIRE(0 == v[10]);
+        REQUIRE(7 == v[7]);
+
+        REQUIRE(0 == m.subslice({{3,0}},{{1,1}}).count());
+    }
+
+    SECTION("tiled_transpose")
+    {
+        std::vector<int> t(12);
+        slice2d<int> mt(make_slice(t),{{4,3}});
+
+        size_t tiles = 0;
+        m.tiles(2, 3, [&](slice2d<int> tile, slice2d<int>::index const& at){
+            ++tiles;
+            for(size_t y = 0; y < tile.size(0); ++y){
+                for(size_t x = 0; x < tile.size(1); ++x){
+                    mt(at[1]+x,at[0]+y) >>[&](int& d){ d = ~tile(y,x); };
+                }
+            }
+        });
+        REQUIRE(4 == tiles);
+        for(size_t y = 0; y < 3; ++y){
+            for(size_t x = 0; x < 4; ++x){
+                REQUIRE(~m(y,x) == ~mt(x,y));
+            }
+        }
+    }
+
+    SECTION("default_tiles")
+    {
+        REQUIRE(64 == fn_::tile_edge<float>());
+        REQUIRE(32 == fn_::tile_edge<double>());
+
+        size_t tiles = 0;
+        m.tiles([&](slice2d<int> tile, slice2d<int>::index const&){
+            ++tiles;
+            REQUIRE(12 == tile.count());
+        });
+        REQUIRE(1 == tiles);
+    }
+}
+
+TEST_CASE("slice_nd with rank 3")
+{
+    std::vector<int> v(24);
+    for(size_t i = 0; i < v.size(); ++i){ v[i] = int(i); }
+    slice_nd<int,3> c(make_slice(v),{{2,3,4}});
+
+    REQUIRE(12 == c.stride(0));
+    REQUIRE(23 == ~c(1,2,3));
+
+    auto s = c.subslice({{1,1,1}},{{1,2,2}});
+    std::vector<int> seen;
+    s.rows([&](slice<int> r){
+        for(auto x: r){ seen.push_back(x); }
+    });
+    REQUIRE(4 == seen.size());
+    REQUIRE(17 == seen[0]);
+    REQUIRE(18 == seen[1]);
+    REQUIRE(21 == seen[2]);
+    REQUIRE(22 == seen[3]);
+}
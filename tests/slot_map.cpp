@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <fn/slot_map.hpp>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+TEST_CASE("slot_map")
+{
+    slot_map<std::string> m;
+    CHECK(m.empty());
+    CHECK(4 == sizeof(slot_map<std::string>::handle));
+
+    auto a = m.insert("a");
+    auto b = m.insert("b");
+    auto c = m.insert("c");
+    CHECK(3 == m.size());
+
+    CHECK("a" == ~m.get(a));
+    CHECK("b" == ~m.get(b));
+    CHECK("c" == ~m.get(c));
+    CHECK_FALSE(m.get(slot_map<std::string>::handle()).valid());
+
+    SECTION("erase"){
+        CHECK(m.erase(a));
+        CHECK_FALSE(m.erase(a));
+        CHECK_FALSE(m.get(a).valid());
+        CHECK_FALSE(m.contains(a));
+        CHECK(2 == m.size());
+
+        // the last value moved into the gap, its handle still resolves
+        CHECK("c" == ~m.get(c));
+        CHECK("b" == ~m.get(b));
+        CHECK("c" == *m.begin());
+        CHECK(c == m.handle_at(0));
+    }
+
+    SECTION("stale_handle_after_reuse"){
+        m.erase(b);
+        auto d = m.insert("d");
+        CHECK(d.index() == b.index());
+        CHECK(d != b);
+        CHECK_FALSE(m.get(b).valid());
+        CHECK("d" == ~m.get(d));
+    }
+
+    SECTION("iteration"){
+        std::string all;
+        for(auto const& s: m){ all += s; }
+        CHECK("abc" == all);
+
+        m.get(b) >>[](std::string& s){ s = "B"; };
+        slot_map<std::string> const& cm = m;
+        CHECK("B" == ~cm.get(b));
+    }
+
+    SECTION("clear"){
+        m.clear();
+        CHECK(m.empty());
+        CHECK_FALSE(m.contains(a));
+        CHECK_FALSE(m.contains(c));
+    }
+}
+
+TEST_CASE("slot_map retires exhausted slots")
+{
+    // 28 index bits leave 4 bits, 15 generations, for each slot
+    slot_map<int,28> m;
+    std::vector<slot_map<int,28>::handle> old;
+    for(int i = 0; i < 15; ++i){
+        auto h = m.insert(i);
+        REQUIRE(0 == h.index());
+        old.push_back(h);
+        m.erase(h);
+    }
+    auto h = m.insert(99);
+    CHECK(1 == h.index());
+    for(auto o: old){
+        CHECK_FALSE(m.contains(o));
+    }
+}
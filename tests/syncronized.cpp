@@ -4,6 +4,9 @@
 #include <vector>
 #include <map>
 #include <utility>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include "catch.hpp"
 using namespace fn;
 
@@ -14,6 +17,21 @@ struct DummyMutex
 {
     void lock(){ lock_count++; }
     void unlock(){ unlock_count++; }
+    bool try_lock(){ lock_count++; return true; }
+};
+
+struct BusyOnceMutex
+{
+    int busy = 1;
+    int locked = 0;
+    void lock(){ locked++; }
+    void unlock(){ locked--; }
+    bool try_lock()
+    {
+        if(busy){ busy--; return false; }
+        locked++;
+        return true;
+    }
 };
 
 TEST_CASE("synchronized")
@@ -212,3 +230,221 @@ TEST_CASE("synchronized")
         REQUIRE(2 == unlock_count);
     }
 }
+
+TEST_CASE("synchronize")
+{
+    SECTION("locks_all_and_unlocks_all")
+    {
+        lock_count = 0;
+        unlock_count = 0;
+        auto a = synchronized<int,DummyMutex>(1);
+        auto const b = synchronized<int,DummyMutex>(2);
+        auto c = synchronized<std::vector<int>,DummyMutex>(std::vector<int>{3});
+
+        auto sum = synchronize(a,b,c) >>[&](int& a, int const& b, std::vector<int>& c){
+            REQUIRE(3 == lock_count);
+            REQUIRE(0 == unlock_count);
+            a = 10;
+            return a + b + c[0];
+        };
+
+        REQUIRE(15 == sum);
+        REQUIRE(3 == lock_count);
+        REQUIRE(3 == unlock_count);
+        REQUIRE(10 == *a.guard());
+    }
+
+    SECTION("backs_off_when_busy")
+    {
+        auto a = synchronized<int,BusyOnceMutex>(1);
+        auto b = synchronized<int,BusyOnceMutex>(2);
+
+        synchronize(a,b) >>[&](int& a, int& b){
+            std::swap(a,b);
+        };
+
+        REQUIRE(2 == *a.guard());
+        REQUIRE(1 == *b.guard());
+    }
+
+    SECTION("result_does_not_reference_guarded_value")
+    {
+        auto a = synchronized<int,DummyMutex>(1);
+        auto b = synchronized<int,DummyMutex>(2);
+
+        auto x = synchronize(a,b) >>[](int& a, int&) -> int& { return a; };
+        REQUIRE(1 == x);
+        x = 7;
+        REQUIRE(1 == *a.guard());
+    }
+
+    SECTION("opposite_order_from_threads")
+    {
+        synchronized<int,std::mutex> a(1000);
+        synchronized<int,std::mutex> b(1000);
+
+        auto transfer = [](synchronized<int,std::mutex>& from,
+                           synchronized<int,std::mutex>& to){
+            for(int i = 0; i < 10000; ++i){
+                synchronize(from,to) >>[](int& f, int& t){ --f; ++t; };
+            }
+        };
+
+        std::thread t1(transfer, std::ref(a), std::ref(b));
+        std::thread t2(transfer, std::ref(b), std::ref(a));
+        t1.join();
+        t2.join();
+
+        REQUIRE(2000 == (synchronize(a,b) >>[](int& a, int& b){ return a + b; }));
+        REQUIRE(1000 == *a.guard());
+    }
+}
+
+TEST_CASE("synchronized wait_until")
+{
+    SECTION("does_not_block_if_predicate_holds")
+    {
+        synchronized<int,std::mutex> x(5);
+        auto r = x.wait_until([](int const& x){ return x == 5; })
+        >>[](int& x) -> int& {
+            x = 6;
+            return x;
+        };
+        r >>[](int& x){ CHECK(6 == x); };
+    }
+
+    SECTION("wakes_when_predicate_holds")
+    {
+        synchronized<int,std::mutex> x(0);
+        std::atomic<int> checks(0);
+        int seen = 0;
+
+        std::thread waiter([&]{
+            x.wait_until([&](int const& x){ ++checks; return x == 3; })
+            >>[&](int& x){ seen = x; x = 10; };
+        });
+
+        while(checks == 0){ std::this_thread::yield(); }
+
+        for(int i = 0; i < 3; ++i){
+            x >>[](int& x){ ++x; };
+        }
+        waiter.join();
+
+        CHECK(3 == seen);
+        CHECK(10 == *x.guard());
+        // once by the waiter, once per write and once more after waking
+        CHECK(5 == checks);
+    }
+
+    SECTION("guard_and_take_wake_waiters")
+    {
+        synchronized<std::vector<int>,std::mutex> x;
+
+        std::thread waiter([&]{
+            x.wait_until([](std::vector<int> const& v){ return v.size() == 2; })
+            >>[](std::vector<int>& v){ v.push_back(3); };
+        });
+
+        x.guard()->push_back(1);
+        x.guard()->push_back(2);
+        waiter.join();
+
+        CHECK(3 == x.take().size());
+    }
+
+    SECTION("notify")
+    {
+        synchronized<int,std::mutex> x(0);
+        std::atomic<bool> go(false);
+
+        std::thread waiter([&]{
+            x.wait_until([&](int const&){ return go.load(); })
+            >>[](int& x){ x = 1; };
+        });
+
+        go = true;
+        while(0 == *x.guard()){
+            x.notify();
+            std::this_thread::yield();
+        }
+        waiter.join();
+        CHECK(1 == *x.guard());
+    }
+}
+
+TEST_CASE("synchronized try_apply and apply_for")
+{
+    SECTION("try_apply_skips_when_busy")
+    {
+        auto x = synchronized<int,BusyOnceMutex>(1);
+        bool skipped = false;
+
+        x.try_apply([](int& x){ x = 2; })
+        ||[&]{ skipped = true; };
+        CHECK(skipped);
+        CHECK(1 == *x.guard());
+
+        skipped = false;
+        x.try_apply([](int& x){ x = 3; })
+        ||[&]{ skipped = true; };
+        CHECK_FALSE(skipped);
+        CHECK(3 == *x.guard());
+        CHECK(0 == x.get_mutex().locked);
+    }
+
+    SECTION("try_apply_chains")
+    {
+        auto x = synchronized<std::vector<int>,DummyMutex>(std::vector<int>{4,5});
+        int seen = 0;
+
+        x.try_apply([](std::vector<int>& v) -> int& { return v[1]; })
+        >>[&](int& i){ seen = i; };
+        CHECK(5 == seen);
+    }
+
+    SECTION("value_results_are_optional")
+    {
+        auto x = synchronized<int,BusyOnceMutex>(21);
+
+        auto busy = x.try_apply([](int& x){ return 2*x; });
+        CHECK_FALSE(busy.valid());
+
+        auto r = x.try_apply([](int& x){ return 2*x; });
+        CHECK(42 == ~r);
+        CHECK(0 == x.get_mutex().locked);
+
+        CHECK(42 == ~(x >>[](int& x){ return 2*x; }));
+    }
+
+    SECTION("apply_for_times_out")
+    {
+        synchronized<int,std::timed_mutex> x(1);
+        synchronized<int,std::mutex> y(1);
+
+        std::atomic<bool> locked(false);
+        std::atomic<bool> done(false);
+        std::thread holder([&]{
+            auto gx = x.guard();
+            auto gy = y.guard();
+            locked = true;
+            while(!done){ std::this_thread::yield(); }
+        });
+        while(!locked){ std::this_thread::yield(); }
+
+        auto const start = std::chrono::steady_clock::now();
+        auto rx = x.apply_for(std::chrono::milliseconds(10), [](int& x){ return x; });
+        auto ry = y.apply_for(std::chrono::milliseconds(10), [](int& y){ return y; });
+        auto const waited = std::chrono::steady_clock::now() - start;
+
+        CHECK_FALSE(rx.valid());
+        CHECK_FALSE(ry.valid());
+        CHECK(waited >= std::chrono::milliseconds(20));
+
+        done = true;
+        holder.join();
+
+        CHECK(1 == ~x.apply_for(std::chrono::milliseconds(10), [](int& x){ return x; }));
+        CHECK(1 == ~y.apply_for(std::chrono::milliseconds(10), [](int& y){ return y; }));
+    }
+}
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <fn/versioned_cell.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+using namespace fn;
+
+struct Limits
+{
+    int used;
+    int max;
+};
+
+TEST_CASE("versioned_cell")
+{
+    SECTION("update_and_read")
+    {
+        versioned_cell<std::string> c("abc");
+        CHECK(0 == c.version());
+        CHECK("abc" == c.get());
+
+        CHECK(0 == c.update([](std::string& s){ s += "d"; }));
+        CHECK(1 == c.version());
+        CHECK(4 == c.read([](std::string const& s){ return s.size(); }));
+        CHECK(1 == c.commits());
+        CHECK(0 == c.retries());
+    }
+
+    SECTION("retries_on_concurrent_update")
+    {
+        versioned_cell<Limits> c(Limits{0,10});
+        bool first = true;
+
+        auto const retries = c.update([&](Limits& l){
+            if(first){
+                first = false;
+                c.update([](Limits& l){ l.max = 20; });
+            }
+            l.used += 1;
+        });
+
+        CHECK(1 == retries);
+        CHECK(2 == c.version());
+        CHECK(1 == c.get().used);
+        CHECK(20 == c.get().max);
+        CHECK(2 == c.commits());
+        CHECK(1 == c.retries());
+    }
+
+    SECTION("concurrent_updates_are_not_lost")
+    {
+        versioned_cell<Limits> c(Limits{0,0});
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t){
+            threads.emplace_back([&]{
+                for(int i = 0; i < 1000; ++i){
+                    c.update([](Limits& l){ l.used++; l.max += 2; });
+                }
+            });
+        }
+        for(auto& t: threads){ t.join(); }
+
+        auto const l = c.get();
+        CHECK(4000 == l.used);
+        CHECK(8000 == l.max);
+        CHECK(4000 == c.version());
+        CHECK(4000 == c.commits());
+    }
+}